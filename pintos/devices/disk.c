@@ -84,7 +84,7 @@ static void reset_channel(struct channel *);
 static bool check_device_type(struct disk *);
 static void identify_ata_device(struct disk *);
 
-static void select_sector(struct disk *, disk_sector_t);
+static void select_sector(struct disk *, disk_sector_t, size_t cnt);
 static void issue_pio_command(struct channel *, uint8_t command);
 static void input_sector(struct channel *, void *);
 static void output_sector(struct channel *, const void *);
@@ -215,7 +215,7 @@ void disk_read(struct disk *d, disk_sector_t sec_no, void *buffer)
 
 	c = d->channel;
 	lock_acquire(&c->lock);
-	select_sector(d, sec_no);
+	select_sector(d, sec_no, 1);
 	issue_pio_command(c, CMD_READ_SECTOR_RETRY);
 	sema_down(&c->completion_wait);
 	if (!wait_while_busy(d))
@@ -239,7 +239,7 @@ void disk_write(struct disk *d, disk_sector_t sec_no, const void *buffer)
 
 	c = d->channel;
 	lock_acquire(&c->lock);
-	select_sector(d, sec_no);
+	select_sector(d, sec_no, 1);
 	issue_pio_command(c, CMD_WRITE_SECTOR_RETRY);
 	if (!wait_while_busy(d))
 		PANIC("%s: disk write failed, sector=%" PRDSNu, d->name, sec_no);
@@ -249,6 +249,64 @@ void disk_write(struct disk *d, disk_sector_t sec_no, const void *buffer)
 	lock_release(&c->lock);
 }
 
+/* Reads CNT consecutive sectors starting at SEC_NO from disk D
+   into BUFFER, which must have room for CNT * DISK_SECTOR_SIZE
+   bytes.  All sectors are transferred by a single READ SECTOR
+   command, so the channel is programmed only once.
+   CNT must be between 1 and DISK_MAX_SECTORS. */
+void disk_read_multiple(struct disk *d, disk_sector_t sec_no, void *buffer, size_t cnt)
+{
+	struct channel *c;
+	size_t i;
+
+	ASSERT(d != NULL);
+	ASSERT(buffer != NULL);
+	ASSERT(cnt > 0 && cnt <= DISK_MAX_SECTORS);
+
+	c = d->channel;
+	lock_acquire(&c->lock);
+	select_sector(d, sec_no, cnt);
+	issue_pio_command(c, CMD_READ_SECTOR_RETRY);
+	for (i = 0; i < cnt; i++) {
+		/* The device interrupts once per sector it has ready. */
+		sema_down(&c->completion_wait);
+		if (!wait_while_busy(d))
+			PANIC("%s: disk read failed, sector=%" PRDSNu, d->name, (disk_sector_t)(sec_no + i));
+		input_sector(c, (uint8_t *)buffer + i * DISK_SECTOR_SIZE);
+		d->read_cnt++;
+	}
+	lock_release(&c->lock);
+}
+
+/* Writes CNT consecutive sectors starting at SEC_NO to disk D
+   from BUFFER, which must contain CNT * DISK_SECTOR_SIZE bytes.
+   All sectors are transferred by a single WRITE SECTOR command.
+   Returns after the disk has acknowledged the last sector.
+   CNT must be between 1 and DISK_MAX_SECTORS. */
+void disk_write_multiple(struct disk *d, disk_sector_t sec_no, const void *buffer, size_t cnt)
+{
+	struct channel *c;
+	size_t i;
+
+	ASSERT(d != NULL);
+	ASSERT(buffer != NULL);
+	ASSERT(cnt > 0 && cnt <= DISK_MAX_SECTORS);
+
+	c = d->channel;
+	lock_acquire(&c->lock);
+	select_sector(d, sec_no, cnt);
+	issue_pio_command(c, CMD_WRITE_SECTOR_RETRY);
+	for (i = 0; i < cnt; i++) {
+		if (!wait_while_busy(d))
+			PANIC("%s: disk write failed, sector=%" PRDSNu, d->name, (disk_sector_t)(sec_no + i));
+		output_sector(c, (const uint8_t *)buffer + i * DISK_SECTOR_SIZE);
+		/* The device interrupts once per sector it has accepted. */
+		sema_down(&c->completion_wait);
+		d->write_cnt++;
+	}
+	lock_release(&c->lock);
+}
+
 /* Disk detection and identification. */
 
 static void print_ata_string(char *string, size_t size);
@@ -398,17 +456,18 @@ static void print_ata_string(char *string, size_t size)
 }
 
 /* Selects device D, waiting for it to become ready, and then
-   writes SEC_NO to the disk's sector selection registers.  (We
-   use LBA mode.) */
-static void select_sector(struct disk *d, disk_sector_t sec_no)
+   writes SEC_NO and the sector count CNT to the disk's sector
+   selection registers.  (We use LBA mode.) */
+static void select_sector(struct disk *d, disk_sector_t sec_no, size_t cnt)
 {
 	struct channel *c = d->channel;
 
-	ASSERT(sec_no < d->capacity);
+	ASSERT(sec_no + cnt <= d->capacity);
 	ASSERT(sec_no < (1UL << 28));
+	ASSERT(cnt > 0 && cnt <= DISK_MAX_SECTORS);
 
 	select_device_wait(d);
-	outb(reg_nsect(c), 1);
+	outb(reg_nsect(c), cnt);
 	outb(reg_lbal(c), sec_no);
 	outb(reg_lbam(c), sec_no >> 8);
 	outb(reg_lbah(c), (sec_no >> 16));
@@ -114,6 +114,26 @@ off_t file_write_at(struct file *file, const void *buffer, off_t size, off_t fil
 	return inode_write_at(file->inode, buffer, size, file_ofs);
 }
 
+/* Reads from FILE, starting at offset FILE_OFS, into the CNT
+ * buffers in IOV one after another, as a single read of the file.
+ * Returns the number of bytes actually read.
+ * The file's current position is unaffected. */
+off_t file_readv_at(struct file *file, const struct inode_iovec *iov, size_t cnt,
+					off_t file_ofs)
+{
+	return inode_readv_at(file->inode, iov, cnt, file_ofs);
+}
+
+/* Writes the CNT buffers in IOV one after another into FILE,
+ * starting at offset FILE_OFS, as a single write of the file.
+ * Returns the number of bytes actually written.
+ * The file's current position is unaffected. */
+off_t file_writev_at(struct file *file, const struct inode_iovec *iov, size_t cnt,
+					 off_t file_ofs)
+{
+	return inode_writev_at(file->inode, iov, cnt, file_ofs);
+}
+
 /* Prevents write operations on FILE's underlying inode
  * until file_allow_write() is called or FILE is closed. */
 void file_deny_write(struct file *file)
@@ -7,10 +7,16 @@
 #include "filesys/inode.h"
 #include "filesys/directory.h"
 #include "devices/disk.h"
+#include "threads/synch.h"
 
 /* The disk that contains the file system. */
 struct disk *filesys_disk;
 
+/* Serializes changes to directory contents, so that looking up a
+ * name and then adding or removing it happens atomically.  File
+ * data is protected per inode instead; see inode.c. */
+static struct lock dir_lock;
+
 static void do_format(void);
 
 /* Initializes the file system module.
@@ -22,6 +28,7 @@ void filesys_init(bool format)
 		PANIC("hd0:1 (hdb) not present, file system initialization failed");
 
 	inode_init();
+	lock_init(&dir_lock);
 
 #ifdef EFILESYS
 	fat_init();
@@ -60,12 +67,14 @@ void filesys_done(void)
 bool filesys_create(const char *name, off_t initial_size)
 {
 	disk_sector_t inode_sector = 0;
+	lock_acquire(&dir_lock);
 	struct dir *dir = dir_open_root();
 	bool success = (dir != NULL && free_map_allocate(1, &inode_sector) &&
 					inode_create(inode_sector, initial_size) && dir_add(dir, name, inode_sector));
 	if (!success && inode_sector != 0)
 		free_map_release(inode_sector, 1);
 	dir_close(dir);
+	lock_release(&dir_lock);
 
 	return success;
 }
@@ -77,12 +86,14 @@ bool filesys_create(const char *name, off_t initial_size)
  * or if an internal memory allocation fails. */
 struct file *filesys_open(const char *name)
 {
-	struct dir *dir = dir_open_root();
 	struct inode *inode = NULL;
 
+	lock_acquire(&dir_lock);
+	struct dir *dir = dir_open_root();
 	if (dir != NULL)
 		dir_lookup(dir, name, &inode);
 	dir_close(dir);
+	lock_release(&dir_lock);
 
 	return file_open(inode);
 }
@@ -93,9 +104,11 @@ struct file *filesys_open(const char *name)
  * or if an internal memory allocation fails. */
 bool filesys_remove(const char *name)
 {
+	lock_acquire(&dir_lock);
 	struct dir *dir = dir_open_root();
 	bool success = dir != NULL && dir_remove(dir, name);
 	dir_close(dir);
+	lock_release(&dir_lock);
 
 	return success;
 }
@@ -4,9 +4,11 @@
 #include "filesys/file.h"
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
+#include "threads/synch.h"
 
 static struct file *free_map_file; /* Free map file. */
 static struct bitmap *free_map;	   /* Free map, one bit per disk sector. */
+static struct lock free_map_lock;  /* Protects free_map and its file. */
 
 /* Initializes the free map. */
 void free_map_init(void)
@@ -14,6 +16,7 @@ void free_map_init(void)
 	free_map = bitmap_create(disk_size(filesys_disk));
 	if (free_map == NULL)
 		PANIC("bitmap creation failed--disk is too large");
+	lock_init(&free_map_lock);
 	bitmap_mark(free_map, FREE_MAP_SECTOR);
 	bitmap_mark(free_map, ROOT_DIR_SECTOR);
 }
@@ -24,11 +27,13 @@ void free_map_init(void)
  * available. */
 bool free_map_allocate(size_t cnt, disk_sector_t *sectorp)
 {
+	lock_acquire(&free_map_lock);
 	disk_sector_t sector = bitmap_scan_and_flip(free_map, 0, cnt, false);
 	if (sector != BITMAP_ERROR && free_map_file != NULL && !bitmap_write(free_map, free_map_file)) {
 		bitmap_set_multiple(free_map, sector, cnt, false);
 		sector = BITMAP_ERROR;
 	}
+	lock_release(&free_map_lock);
 	if (sector != BITMAP_ERROR)
 		*sectorp = sector;
 	return sector != BITMAP_ERROR;
@@ -37,9 +42,11 @@ bool free_map_allocate(size_t cnt, disk_sector_t *sectorp)
 /* Makes CNT sectors starting at SECTOR available for use. */
 void free_map_release(disk_sector_t sector, size_t cnt)
 {
+	lock_acquire(&free_map_lock);
 	ASSERT(bitmap_all(free_map, sector, cnt));
 	bitmap_set_multiple(free_map, sector, cnt, false);
 	bitmap_write(free_map, free_map_file);
+	lock_release(&free_map_lock);
 }
 
 /* Opens the free map file and reads it from disk. */
@@ -6,6 +6,7 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/synch.h"
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -33,6 +34,7 @@ struct inode {
 	int open_cnt;			/* Number of openers. */
 	bool removed;			/* True if deleted, false otherwise. */
 	int deny_write_cnt;		/* 0: writes ok, >0: deny writes. */
+	struct rwlock rwlock;	/* Shared by readers, exclusive for writes. */
 	struct inode_disk data; /* Inode content. */
 };
 
@@ -53,10 +55,17 @@ static disk_sector_t byte_to_sector(const struct inode *inode, off_t pos)
  * returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* Protects open_inodes and the open_cnt and removed members of
+ * each inode in it.  Held only briefly, never across file data
+ * I/O, so that opening and closing files does not wait for reads
+ * and writes of unrelated files. */
+static struct lock open_inodes_lock;
+
 /* Initializes the inode module. */
 void inode_init(void)
 {
 	list_init(&open_inodes);
+	lock_init(&open_inodes_lock);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -104,35 +113,46 @@ struct inode *inode_open(disk_sector_t sector)
 	struct list_elem *e;
 	struct inode *inode;
 
+	lock_acquire(&open_inodes_lock);
+
 	/* Check whether this inode is already open. */
 	for (e = list_begin(&open_inodes); e != list_end(&open_inodes); e = list_next(e)) {
 		inode = list_entry(e, struct inode, elem);
 		if (inode->sector == sector) {
-			inode_reopen(inode);
+			inode->open_cnt++;
+			lock_release(&open_inodes_lock);
 			return inode;
 		}
 	}
 
 	/* Allocate memory. */
 	inode = malloc(sizeof *inode);
-	if (inode == NULL)
+	if (inode == NULL) {
+		lock_release(&open_inodes_lock);
 		return NULL;
+	}
 
-	/* Initialize. */
+	/* Initialize.  The inode is read in before the lock is
+	 * released, so other openers never see it half-built. */
 	list_push_front(&open_inodes, &inode->elem);
 	inode->sector = sector;
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
+	rwlock_init(&inode->rwlock);
 	disk_read(filesys_disk, inode->sector, &inode->data);
+	lock_release(&open_inodes_lock);
 	return inode;
 }
 
 /* Reopens and returns INODE. */
 struct inode *inode_reopen(struct inode *inode)
 {
-	if (inode != NULL)
+	if (inode != NULL) {
+		lock_acquire(&open_inodes_lock);
 		inode->open_cnt++;
+		lock_release(&open_inodes_lock);
+	}
 	return inode;
 }
 
@@ -152,10 +172,15 @@ void inode_close(struct inode *inode)
 		return;
 
 	/* Release resources if this was the last opener. */
-	if (--inode->open_cnt == 0) {
+	lock_acquire(&open_inodes_lock);
+	bool last = --inode->open_cnt == 0;
+	if (last) {
 		/* Remove from inode list and release lock. */
 		list_remove(&inode->elem);
+	}
+	lock_release(&open_inodes_lock);
 
+	if (last) {
 		/* Deallocate blocks if removed. */
 		if (inode->removed) {
 			free_map_release(inode->sector, 1);
@@ -171,17 +196,19 @@ void inode_close(struct inode *inode)
 void inode_remove(struct inode *inode)
 {
 	ASSERT(inode != NULL);
+	lock_acquire(&open_inodes_lock);
 	inode->removed = true;
+	lock_release(&open_inodes_lock);
 }
 
-/* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
- * Returns the number of bytes actually read, which may be less
- * than SIZE if an error occurs or end of file is reached. */
-off_t inode_read_at(struct inode *inode, void *buffer_, off_t size, off_t offset)
+/* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET,
+ * with INODE's lock already held.  *BOUNCE is a sector-sized buffer for
+ * partial sectors, allocated on first use and freed by the caller.
+ * Returns the number of bytes actually read. */
+static off_t read_locked(struct inode *inode, uint8_t *buffer, off_t size, off_t offset,
+						 uint8_t **bounce)
 {
-	uint8_t *buffer = buffer_;
 	off_t bytes_read = 0;
-	uint8_t *bounce = NULL;
 
 	while (size > 0) {
 		/* Disk sector to read, starting byte offset within sector. */
@@ -204,13 +231,13 @@ off_t inode_read_at(struct inode *inode, void *buffer_, off_t size, off_t offset
 		} else {
 			/* Read sector into bounce buffer, then partially copy
 			 * into caller's buffer. */
-			if (bounce == NULL) {
-				bounce = malloc(DISK_SECTOR_SIZE);
-				if (bounce == NULL)
+			if (*bounce == NULL) {
+				*bounce = malloc(DISK_SECTOR_SIZE);
+				if (*bounce == NULL)
 					break;
 			}
-			disk_read(filesys_disk, sector_idx, bounce);
-			memcpy(buffer + bytes_read, bounce + sector_ofs, chunk_size);
+			disk_read(filesys_disk, sector_idx, *bounce);
+			memcpy(buffer + bytes_read, *bounce + sector_ofs, chunk_size);
 		}
 
 		/* Advance. */
@@ -218,24 +245,16 @@ off_t inode_read_at(struct inode *inode, void *buffer_, off_t size, off_t offset
 		offset += chunk_size;
 		bytes_read += chunk_size;
 	}
-	free(bounce);
-
 	return bytes_read;
 }
 
-/* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
- * Returns the number of bytes actually written, which may be
- * less than SIZE if end of file is reached or an error occurs.
- * (Normally a write at end of file would extend the inode, but
- * growth is not yet implemented.) */
-off_t inode_write_at(struct inode *inode, const void *buffer_, off_t size, off_t offset)
+/* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET, with
+ * INODE's lock already held for writing.  *BOUNCE is as for
+ * read_locked().  Returns the number of bytes actually written. */
+static off_t write_locked(struct inode *inode, const uint8_t *buffer, off_t size, off_t offset,
+						  uint8_t **bounce)
 {
-	const uint8_t *buffer = buffer_;
 	off_t bytes_written = 0;
-	uint8_t *bounce = NULL;
-
-	if (inode->deny_write_cnt)
-		return 0;
 
 	while (size > 0) {
 		/* Sector to write, starting byte offset within sector. */
@@ -257,9 +276,9 @@ off_t inode_write_at(struct inode *inode, const void *buffer_, off_t size, off_t
 			disk_write(filesys_disk, sector_idx, buffer + bytes_written);
 		} else {
 			/* We need a bounce buffer. */
-			if (bounce == NULL) {
-				bounce = malloc(DISK_SECTOR_SIZE);
-				if (bounce == NULL)
+			if (*bounce == NULL) {
+				*bounce = malloc(DISK_SECTOR_SIZE);
+				if (*bounce == NULL)
 					break;
 			}
 
@@ -267,11 +286,11 @@ off_t inode_write_at(struct inode *inode, const void *buffer_, off_t size, off_t
 			   we're writing, then we need to read in the sector
 			   first.  Otherwise we start with a sector of all zeros. */
 			if (sector_ofs > 0 || chunk_size < sector_left)
-				disk_read(filesys_disk, sector_idx, bounce);
+				disk_read(filesys_disk, sector_idx, *bounce);
 			else
-				memset(bounce, 0, DISK_SECTOR_SIZE);
-			memcpy(bounce + sector_ofs, buffer + bytes_written, chunk_size);
-			disk_write(filesys_disk, sector_idx, bounce);
+				memset(*bounce, 0, DISK_SECTOR_SIZE);
+			memcpy(*bounce + sector_ofs, buffer + bytes_written, chunk_size);
+			disk_write(filesys_disk, sector_idx, *bounce);
 		}
 
 		/* Advance. */
@@ -279,6 +298,92 @@ off_t inode_write_at(struct inode *inode, const void *buffer_, off_t size, off_t
 		offset += chunk_size;
 		bytes_written += chunk_size;
 	}
+	return bytes_written;
+}
+
+/* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET.
+ * Returns the number of bytes actually read, which may be less
+ * than SIZE if an error occurs or end of file is reached.
+ * Holds INODE's lock for reading, so readers of one inode run in
+ * parallel.  BUFFER must not page fault. */
+off_t inode_read_at(struct inode *inode, void *buffer, off_t size, off_t offset)
+{
+	uint8_t *bounce = NULL;
+
+	rwlock_acquire_read(&inode->rwlock);
+	off_t bytes_read = read_locked(inode, buffer, size, offset, &bounce);
+	rwlock_release_read(&inode->rwlock);
+	free(bounce);
+
+	return bytes_read;
+}
+
+/* Reads from INODE, starting at position OFFSET, into the CNT
+ * buffers in IOV one after another, stopping at the first one that
+ * cannot be filled.  Returns the number of bytes actually read.
+ * Holds INODE's lock for reading across all of them, so the caller
+ * sees no write that lands partway through.  No buffer may page
+ * fault. */
+off_t inode_readv_at(struct inode *inode, const struct inode_iovec *iov, size_t cnt,
+					 off_t offset)
+{
+	off_t bytes_read = 0;
+	uint8_t *bounce = NULL;
+
+	rwlock_acquire_read(&inode->rwlock);
+	for (size_t i = 0; i < cnt; i++) {
+		off_t n = read_locked(inode, iov[i].buf, iov[i].size, offset + bytes_read, &bounce);
+		bytes_read += n;
+		if (n < iov[i].size)
+			break;
+	}
+	rwlock_release_read(&inode->rwlock);
+	free(bounce);
+
+	return bytes_read;
+}
+
+/* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
+ * Returns the number of bytes actually written, which may be
+ * less than SIZE if end of file is reached or an error occurs.
+ * (Normally a write at end of file would extend the inode, but
+ * growth is not yet implemented.)
+ * Holds INODE's lock for writing, so a write excludes readers and
+ * other writers of the same inode only.  BUFFER must not page
+ * fault. */
+off_t inode_write_at(struct inode *inode, const void *buffer, off_t size, off_t offset)
+{
+	off_t bytes_written = 0;
+	uint8_t *bounce = NULL;
+
+	rwlock_acquire_write(&inode->rwlock);
+	if (!inode->deny_write_cnt)
+		bytes_written = write_locked(inode, buffer, size, offset, &bounce);
+	rwlock_release_write(&inode->rwlock);
+	free(bounce);
+
+	return bytes_written;
+}
+
+/* Writes the CNT buffers in IOV one after another into INODE,
+ * starting at OFFSET, stopping at the first one that cannot be
+ * written in full.  Returns the number of bytes actually written.
+ * Holds INODE's lock for writing across all of them, so readers see
+ * either none or all of the write.  No buffer may page fault. */
+off_t inode_writev_at(struct inode *inode, const struct inode_iovec *iov, size_t cnt,
+					  off_t offset)
+{
+	off_t bytes_written = 0;
+	uint8_t *bounce = NULL;
+
+	rwlock_acquire_write(&inode->rwlock);
+	for (size_t i = 0; i < cnt && !inode->deny_write_cnt; i++) {
+		off_t n = write_locked(inode, iov[i].buf, iov[i].size, offset + bytes_written, &bounce);
+		bytes_written += n;
+		if (n < iov[i].size)
+			break;
+	}
+	rwlock_release_write(&inode->rwlock);
 	free(bounce);
 
 	return bytes_written;
@@ -288,8 +393,10 @@ off_t inode_write_at(struct inode *inode, const void *buffer_, off_t size, off_t
    May be called at most once per inode opener. */
 void inode_deny_write(struct inode *inode)
 {
+	rwlock_acquire_write(&inode->rwlock);
 	inode->deny_write_cnt++;
 	ASSERT(inode->deny_write_cnt <= inode->open_cnt);
+	rwlock_release_write(&inode->rwlock);
 }
 
 /* Re-enables writes to INODE.
@@ -297,9 +404,11 @@ void inode_deny_write(struct inode *inode)
  * inode_deny_write() on the inode, before closing the inode. */
 void inode_allow_write(struct inode *inode)
 {
+	rwlock_acquire_write(&inode->rwlock);
 	ASSERT(inode->deny_write_cnt > 0);
 	ASSERT(inode->deny_write_cnt <= inode->open_cnt);
 	inode->deny_write_cnt--;
+	rwlock_release_write(&inode->rwlock);
 }
 
 /* Returns the length, in bytes, of INODE's data. */
@@ -3,8 +3,10 @@
 
 #include "filesys/off_t.h"
 #include <stdbool.h>
+#include <stddef.h>
 
 struct inode;
+struct inode_iovec;
 
 /* Opening and closing files. */
 struct file *file_open(struct inode *);
@@ -18,6 +20,8 @@ off_t file_read(struct file *, void *, off_t);
 off_t file_read_at(struct file *, void *, off_t size, off_t start);
 off_t file_write(struct file *, const void *, off_t);
 off_t file_write_at(struct file *, const void *, off_t size, off_t start);
+off_t file_readv_at(struct file *, const struct inode_iovec *, size_t cnt, off_t start);
+off_t file_writev_at(struct file *, const struct inode_iovec *, size_t cnt, off_t start);
 
 /* Preventing writes. */
 void file_deny_write(struct file *);
@@ -2,11 +2,19 @@
 #define FILESYS_INODE_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include "filesys/off_t.h"
 #include "devices/disk.h"
 
 struct bitmap;
 
+/* One of the buffers that inode_readv_at() or inode_writev_at()
+ * reads or writes under a single hold of the inode's lock. */
+struct inode_iovec {
+	void *buf;
+	off_t size;
+};
+
 void inode_init(void);
 bool inode_create(disk_sector_t, off_t);
 struct inode *inode_open(disk_sector_t);
@@ -15,7 +23,9 @@ disk_sector_t inode_get_inumber(const struct inode *);
 void inode_close(struct inode *);
 void inode_remove(struct inode *);
 off_t inode_read_at(struct inode *, void *, off_t size, off_t offset);
+off_t inode_readv_at(struct inode *, const struct inode_iovec *, size_t cnt, off_t offset);
 off_t inode_write_at(struct inode *, const void *, off_t size, off_t offset);
+off_t inode_writev_at(struct inode *, const struct inode_iovec *, size_t cnt, off_t offset);
 void inode_deny_write(struct inode *);
 void inode_allow_write(struct inode *);
 off_t inode_length(const struct inode *);
@@ -0,0 +1,31 @@
+#ifndef __LIB_KERNEL_LZ_H
+#define __LIB_KERNEL_LZ_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* LZ77 block compression in the style of LZ4.
+
+   A compressed block is a series of sequences.  Each sequence is
+   a token byte, a run of literal bytes, and a match that copies
+   earlier output: the token's high nibble holds the literal
+   count and its low nibble the match length less LZ_MIN_MATCH,
+   with 15 meaning more length bytes follow.  The last sequence
+   has literals only. */
+
+/* Shortest match worth encoding. */
+#define LZ_MIN_MATCH 4
+
+/* Longest input lz_compress() accepts, so that offsets fit in
+   two bytes. */
+#define LZ_MAX_INPUT 65535
+
+/* Entries in the hash table the caller passes to lz_compress(). */
+#define LZ_HASH_BITS 10
+#define LZ_HASH_SIZE (1u << LZ_HASH_BITS)
+
+size_t lz_compress(const void *src, size_t src_len, void *dst, size_t dst_cap, uint16_t *table);
+bool lz_decompress(const void *src, size_t src_len, void *dst, size_t dst_len);
+
+#endif /* lib/kernel/lz.h */
@@ -36,6 +36,16 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Extra for Project 3 */
+	SYS_MSYNC,	 /* Write a memory mapping back to its file. */
+	SYS_MADVISE, /* Give advice about use of memory. */
+	SYS_MEMSTAT, /* Test hook: report memory usage (not in NDEBUG kernels). */
+	SYS_SBRK,	 /* Grow or shrink the heap. */
+	SYS_PREAD,	 /* Read from a file at a given offset. */
+	SYS_PWRITE,	 /* Write to a file at a given offset. */
+	SYS_READV,	 /* Read from a file into several buffers. */
+	SYS_WRITEV,	 /* Write to a file from several buffers. */
 };
 
 #endif /* lib/syscall-nr.h */
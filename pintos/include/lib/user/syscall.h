@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -12,6 +13,34 @@ typedef int pid_t;
 /* Map region identifier. */
 typedef int off_t;
 #define MAP_FAILED ((void *)NULL)
+#define MAP_ANONYMOUS (-1) /* FD for mmap() of zero-filled memory. */
+
+/* Flags for msync(). */
+#define MS_ASYNC 1 /* Schedule the write-back and return. */
+#define MS_SYNC 4  /* Write back before returning. */
+
+/* Advice for madvise(). */
+#define MADV_NORMAL 0	  /* No special treatment. */
+#define MADV_RANDOM 1	  /* Expect random page references. */
+#define MADV_SEQUENTIAL 2 /* Expect sequential page references. */
+#define MADV_WILLNEED 3	  /* Will need these pages. */
+#define MADV_DONTNEED 4	  /* Don't need these pages. */
+
+/* One buffer for readv() and writev(). */
+struct iovec {
+	void *iov_base; /* Start of the buffer. */
+	size_t iov_len; /* Size of the buffer in bytes. */
+};
+#define IOV_MAX 1024 /* Most buffers one readv() or writev() takes. */
+
+/* Memory usage reported by memstat(), a hook for the VM tests.
+ * Kernels built with NDEBUG do not implement it. */
+struct memstat {
+	size_t rss;			 /* Frames holding this process's pages. */
+	size_t wss;			 /* Estimated working set size in pages. */
+	unsigned faults;	 /* Page faults so far. */
+	unsigned fault_rate; /* Page faults per second, recently. */
+};
 
 /* Maximum characters in a filename written by readdir(). */
 #define READDIR_MAX_LEN 14
@@ -41,6 +70,14 @@ int dup2(int oldfd, int newfd);
 /* Project 3 and optionally project 4. */
 void *mmap(void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap(void *addr);
+int msync(void *addr, size_t length, int flags);
+int madvise(void *addr, size_t length, int advice);
+void memstat(struct memstat *stat);
+void *sbrk(intptr_t increment);
+int pread(int fd, void *buffer, unsigned length, off_t offset);
+int pwrite(int fd, const void *buffer, unsigned length, off_t offset);
+int readv(int fd, const struct iovec *iov, int iovcnt);
+int writev(int fd, const struct iovec *iov, int iovcnt);
 
 /* Project 4 only. */
 bool chdir(const char *dir);
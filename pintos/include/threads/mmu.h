@@ -14,9 +14,12 @@ void pml4_destroy(uint64_t *pml4);
 void pml4_activate(uint64_t *pml4);
 void *pml4_get_page(uint64_t *pml4, const void *upage);
 bool pml4_set_page(uint64_t *pml4, void *upage, void *kpage, bool rw);
+bool pml4_set_huge_page(uint64_t *pml4, void *upage, void *kpage, bool rw);
+bool pml4_is_huge(uint64_t *pml4, const void *upage);
 void pml4_clear_page(uint64_t *pml4, void *upage);
 bool pml4_is_dirty(uint64_t *pml4, const void *upage);
 void pml4_set_dirty(uint64_t *pml4, const void *upage, bool dirty);
+void pml4_set_writable(uint64_t *pml4, const void *upage, bool writable);
 bool pml4_is_accessed(uint64_t *pml4, const void *upage);
 void pml4_set_accessed(uint64_t *pml4, const void *upage, bool accessed);
 
@@ -1,6 +1,7 @@
 #ifndef THREADS_PALLOC_H
 #define THREADS_PALLOC_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
 
@@ -17,7 +18,11 @@ extern size_t user_page_limit;
 uint64_t palloc_init(void);
 void *palloc_get_page(enum palloc_flags);
 void *palloc_get_multiple(enum palloc_flags, size_t page_cnt);
+void *palloc_get_aligned(enum palloc_flags, size_t page_cnt, size_t align_cnt);
 void palloc_free_page(void *);
 void palloc_free_multiple(void *, size_t page_cnt);
+bool palloc_prezero(void);
+void *palloc_user_pool_base(void);
+size_t palloc_user_pool_size(void);
 
 #endif /* threads/palloc.h */
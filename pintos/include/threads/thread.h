@@ -151,6 +151,10 @@ void thread_print_stats(void);
 typedef void thread_func(void *aux);
 tid_t thread_create(const char *name, int priority, thread_func *, void *);
 
+/* Performs some operation on thread t, given auxiliary data AUX. */
+typedef void thread_action_func(struct thread *t, void *aux);
+void thread_foreach(thread_action_func *, void *);
+
 void thread_block(void);
 void thread_unblock(struct thread *);
 
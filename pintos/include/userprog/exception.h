@@ -1,11 +1,30 @@
 #ifndef USERPROG_EXCEPTION_H
 #define USERPROG_EXCEPTION_H
 
+#include <stdint.h>
+
 /* Page fault error code bits that describe the cause of the exception.  */
 #define PF_P 0x1 /* 0: not-present page. 1: access rights violation. */
 #define PF_W 0x2 /* 0: read, 1: write. */
 #define PF_U 0x4 /* 0: kernel, 1: user process. */
 
+/* Exception table entry.  If the kernel instruction at INSN page
+   faults on a user address that cannot be paged in, the page
+   fault handler resumes execution at FIXUP instead of panicking. */
+struct exception_table_entry {
+	uint64_t insn;	/* Address of the faulting instruction. */
+	uint64_t fixup; /* Address to resume at. */
+};
+
+/* Assembler text that adds an exception table entry mapping the
+   label INSN to the label FIXUP, for use in inline assembly that
+   accesses user memory, e.g. EX_TABLE_ENTRY ("1b", "2f"). */
+#define EX_TABLE_ENTRY(INSN, FIXUP)                                                                \
+	".pushsection .ex_table, \"a\"\n"                                                              \
+	".balign 8\n"                                                                                  \
+	".quad " INSN ", " FIXUP "\n"                                                                  \
+	".popsection\n"
+
 void exception_init(void);
 void exception_print_stats(void);
 
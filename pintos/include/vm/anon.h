@@ -5,10 +5,22 @@ struct page;
 enum vm_type;
 
 struct anon_page {
-    int swap_table_index;
+    size_t swap_table_index;
+    size_t zswap_index; /* 압축 스왑 아레나에 있으면 그 첫 청크 번호, 없으면 BITMAP_ERROR */
+    bool readahead; /* readahead로 읽어 둔 뒤 아직 쓰이지 않음 (슬롯 내용과 같음) */
+    bool zero;      /* 프레임 없이 공용 zero 프레임에 읽기 전용으로 매핑됨 */
 };
 
+extern size_t vm_zswap_pages;
+
 void vm_anon_init(void);
+void vm_anon_print_stats(void);
 bool anon_initializer(struct page *page, enum vm_type type, void *kva);
+bool anon_swap_readahead(struct page *page, void *kva);
+void anon_readahead_settle(struct page *page);
+void anon_swap_share(struct page *page, struct page *src);
+void anon_swap_batch_begin(void);
+void anon_swap_batch_end(void);
+void *do_mmap_anon(void *addr, size_t length, int writable);
 
 #endif
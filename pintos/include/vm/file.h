@@ -10,20 +10,22 @@ struct file_page {
 	struct file *file;		  // 매핑된 파일 객체
 	uint64_t offset;		  // 파일 객체의 오프셋 값
 	uint32_t page_read_bytes; // 페이지에서 읽어야 하는 바이트의 개수
-	uint32_t mmap_index;
-	uint32_t mmap_length;
+	bool shared; // 실행 파일의 읽기 전용 세그먼트 (text cache로 프로세스 간 공유)
 };
 
 struct mmap_aux {
 	struct file *file;
 	uint64_t offset;
 	uint32_t page_read_bytes;
-	uint32_t mmap_index;
-	uint32_t mmap_length;
+	bool shared;
+	uint8_t fault_around; // fault 시 함께 읽을 창 크기 (페이지 수)
 };
 
 void vm_file_init(void);
 bool file_backed_initializer(struct page *page, enum vm_type type, void *kva);
 void *do_mmap(void *addr, size_t length, int writable, struct file *file, off_t offset);
 void do_munmap(void *va);
+bool do_msync(void *addr, size_t length, bool sync);
+bool vm_map_text_segment(void *upage, struct file *file, off_t offset, size_t read_bytes,
+						 size_t zero_bytes);
 #endif
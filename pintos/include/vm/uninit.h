@@ -21,8 +21,10 @@ struct uninit_page {
 struct vm_load_aux {
 	uint64_t offset;		  // 파일 객체의 오프셋 값
 	uint32_t page_read_bytes; // 페이지에서 읽어야 하는 바이트의 개수
+	uint8_t fault_around;	  // fault 시 함께 읽을 창 크기 (페이지 수)
 };
 
 void uninit_new(struct page *page, void *va, vm_initializer *init, enum vm_type type, void *aux,
 				bool (*initializer)(struct page *, enum vm_type, void *kva));
+bool uninit_transmute(struct page *page, void *kva);
 #endif
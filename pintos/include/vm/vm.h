@@ -1,8 +1,9 @@
 #ifndef VM_VM_H
 #define VM_VM_H
+#include <list.h>
 #include <stdbool.h>
 #include "threads/palloc.h"
-#include "hash.h"
+#include "threads/synch.h"
 
 enum vm_type {
 	/* page not initialized */
@@ -25,6 +26,20 @@ enum vm_type {
 	VM_MARKER_END = (1 << 31),
 };
 
+/* fault-around 창 크기 (페이지 수). 매핑마다 vm_set_fault_around()로 바꿀 수 있다. */
+#define VM_FAULT_AROUND_DEFAULT 8
+#define VM_FAULT_AROUND_MAX 16
+
+/* madvise()로 받는 접근 방식 힌트. lib/user/syscall.h의 MADV_* 값과 같다.
+ * 앞의 세 가지는 영역(struct vma)에 남고, 뒤의 두 가지는 호출할 때 한 번 적용된다. */
+enum vm_advice {
+	VM_ADV_NORMAL = 0,	   /* 기본 fault-around와 readahead */
+	VM_ADV_RANDOM = 1,	   /* fault-around와 swap readahead를 하지 않는다 */
+	VM_ADV_SEQUENTIAL = 2, /* 창을 최대로 키우고 지나간 페이지를 먼저 내보낸다 */
+	VM_ADV_WILLNEED = 3,   /* 범위를 미리 읽어 매핑한다 */
+	VM_ADV_DONTNEED = 4,   /* 범위의 anon 페이지를 버린다 */
+};
+
 #include "vm/uninit.h"
 #include "vm/anon.h"
 #include "vm/file.h"
@@ -47,7 +62,7 @@ struct page {
 	struct frame *frame; /* Back reference for frame */
 
 	/* Your implementation */
-	struct hash_elem spt_hash_elem;
+	struct list_elem frame_elem; /* frame->page_list의 원소 */
 	bool writable;
 	struct thread *owner_thread;
 
@@ -63,11 +78,20 @@ struct page {
 	};
 };
 
-/* The representation of "frame" */
+/* The representation of "frame"
+ * 프레임 테이블(vm.c의 frame_table) 배열의 원소로, 따로 할당하거나 해제하지 않는다.
+ * lock은 내용을 채우거나 내보내는 동안, 그리고 공개된 프레임에 페이지를 붙이거나 뗄 때 잡는다.
+ * 그래서 lock을 잡고 있으면 page_list와 각 페이지의 frame이 바뀌지 않는다. */
 struct frame {
 	void *kva;
-	struct page *page;
-	struct list_elem frame_elem;
+	struct page *page;		/* 대표 페이지 (page_list의 첫 원소) */
+	struct list page_list;	/* 이 프레임을 공유하는 페이지들 */
+	int ref_cnt;			/* page_list의 길이. 1보다 크면 copy-on-write로 공유 중 */
+	struct lock lock;		/* 내용 I/O와 page_list 변경을 직렬화한다 */
+	unsigned pin_cnt;		/* 0보다 크면 교체 대상에서 제외한다 (frame_table_lock) */
+	bool dirty_hint; /* 교체 검사 중 dirty로 확인된 적이 있음 */
+	bool referenced; /* working set 샘플러가 accessed 비트를 지우며 옮겨 둔 접근 기록 */
+	uint8_t age;	 /* accessed 비트가 꺼진 채로 시계 바늘을 지나친 횟수 */
 };
 
 /* The function table for page operations.
@@ -91,9 +115,35 @@ struct page_operations {
  * We don't want to force you to obey any specific design for this struct.
  * All designs up to you for this. */
 struct supplemental_page_table {
-	struct hash spt_hash;
+	/* va로 찾는 4단계 radix tree. threads/mmu.c의 pml4와 같은 모양으로, 각 단계는 페이지 한 장짜리
+	 * 포인터 512개 배열이고 마지막 단계의 원소가 struct page *다. 처음 삽입할 때 만든다. */
+	void *spt_root;
+	size_t page_cnt; /* 등록된 페이지 수 */
+	struct list vma_list; /* 주소 영역(struct vma)들, 시작 주소 순 */
+	void *heap_start;	  /* sbrk() 힙의 시작. 마지막 ELF 세그먼트 바로 뒤 (페이지 정렬) */
+	void *brk;			  /* 힙의 현재 끝. 힙 영역은 [heap_start, pg_round_up(brk)) */
+
+	/* swap readahead 상태 (vm.c의 swap_readahead 참고) */
+	unsigned ra_window; /* 한 번에 미리 읽을 최대 페이지 수 */
+	unsigned ra_issued; /* 지난 readahead에서 읽은 페이지 수 */
+	unsigned ra_hits;	/* 그 중 실제로 접근된 페이지 수 */
+
+	/* working set 추정과 page-fault-frequency 할당량 (vm.c의 ws_daemon 참고) */
+	size_t rss;			/* 이 프로세스의 페이지가 붙어 있는 프레임 수 (frame_table_lock) */
+	size_t wss;			/* 구간마다 접근된 페이지 수의 이동 평균 */
+	size_t ws_sample;	/* 이번 구간에 accessed 비트가 켜져 있던 페이지 수 */
+	size_t frame_quota; /* 교체할 때 이보다 많은 프레임을 가진 프로세스부터 내보낸다 */
+	unsigned fault_cnt;	 /* 이번 구간의 page fault 수 */
+	unsigned fault_rate; /* 지난 구간의 초당 page fault 수 */
+	unsigned fault_total; /* 지금까지의 page fault 수 */
+	bool ws_active;			  /* ws_daemon이 갱신할 프로세스면 true (frame_table_lock) */
+	struct list_elem ws_elem; /* ws_daemon이 한 구간 동안 모아 둘 때 쓴다 (frame_table_lock) */
+
+	unsigned willneed_cnt; /* pageout 데몬에 맡긴 MADV_WILLNEED 요청 수 (frame_table_lock) */
 };
 
+#include "vm/vma.h"
+
 #include "threads/thread.h"
 void supplemental_page_table_init(struct supplemental_page_table *spt);
 bool supplemental_page_table_copy(struct supplemental_page_table *dst,
@@ -102,6 +152,9 @@ void supplemental_page_table_kill(struct supplemental_page_table *spt);
 struct page *spt_find_page(struct supplemental_page_table *spt, void *va);
 bool spt_insert_page(struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page(struct supplemental_page_table *spt, struct page *page);
+typedef void spt_action_func(struct page *page, void *aux);
+void spt_for_each(struct supplemental_page_table *spt, void *start, void *end,
+				  spt_action_func *action, void *aux);
 
 void vm_init(void);
 bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user, bool write, bool not_present);
@@ -112,6 +165,29 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage, bool writabl
 									vm_initializer *init, void *aux);
 void vm_dealloc_page(struct page *page);
 bool vm_claim_page(void *va);
+struct frame *vm_frame_lookup(void *kva);
+struct frame *vm_frame_lock(struct page *page);
+void vm_frame_unlock(struct frame *frame);
+struct frame *vm_frame_pin(struct page *page);
+void vm_frame_unpin(struct frame *frame);
+struct frame *vm_pin_user(const void *uaddr, bool write);
+void vm_free_frame(struct page *page);
+void vm_set_fault_around(void *addr, size_t length, unsigned pages);
+bool vm_madvise(void *addr, size_t length, enum vm_advice advice);
+void vm_writeback_range(void *start, void *end);
+void vm_writeback_async(void);
 enum vm_type page_get_type(struct page *page);
+void vm_print_stats(void);
+void vm_print_ws(struct thread *t);
+
+/* pageout 데몬의 여유 프레임 워터마크 (페이지 수). 0이면 vm_init()이 유저 풀 크기로 정한다. */
+extern size_t vm_pageout_low;
+extern size_t vm_pageout_high;
+
+/* true면 2MB 전체가 비어 있는 anon 영역을 2MB 페이지 하나로 채운다 (커널 옵션 -hp). */
+extern bool vm_huge_pages;
+
+/* true면 프로세스가 끝날 때 working set 크기와 fault 빈도를 출력한다 (커널 옵션 -ws). */
+extern bool vm_ws_report;
 
 #endif /* VM_VM_H */
@@ -0,0 +1,45 @@
+#ifndef VM_VMA_H
+#define VM_VMA_H
+#include <list.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "filesys/off_t.h"
+#include "vm/vm.h"
+
+struct file;
+struct supplemental_page_table;
+
+/* 가상 주소 영역 (virtual memory area).
+ * 같은 방식으로 채워지는 연속된 페이지 범위를 하나로 기술한다 (mmap 한 번, ELF 세그먼트 하나).
+ * 영역을 만들 때는 struct page를 만들지 않고, 각 페이지에 처음 fault가 날 때
+ * vma_populate()가 uninit 페이지를 만든다. */
+struct vma {
+	void *start;		   /* 시작 주소 (페이지 정렬) */
+	void *end;			   /* 끝 주소 (미포함, 페이지 정렬) */
+	enum vm_type type;	   /* 만들 페이지의 타입과 마커 */
+	bool writable;		   /* 페이지 쓰기 가능 여부 */
+	vm_initializer *init;  /* 페이지 내용을 채우는 lazy load 함수 */
+	struct file *file;	   /* 읽어 들일 파일 (없으면 NULL) */
+	off_t offset;		   /* start에 대응하는 파일 오프셋 */
+	size_t read_bytes;	   /* start부터 파일에서 읽을 바이트 수. 나머지는 0으로 채운다 */
+	bool shared;		   /* 실행 파일의 읽기 전용 세그먼트 (text cache로 공유) */
+	bool owns_file;		   /* mmap 영역: 영역이 사라질 때 file을 닫는다 */
+	bool mapped;		   /* mmap()으로 만든 영역. munmap()으로 없앨 수 있다 */
+	uint8_t fault_around;  /* fault-around 창 크기 (페이지 수) */
+	uint8_t advice;		   /* madvise()로 받은 enum vm_advice (NORMAL, RANDOM, SEQUENTIAL) */
+	struct list_elem elem; /* supplemental_page_table의 vma_list 원소 (start 순) */
+};
+
+struct vma *vma_insert(struct supplemental_page_table *spt, const struct vma *tmpl);
+struct vma *vma_find(struct supplemental_page_table *spt, const void *va);
+bool vma_overlaps(struct supplemental_page_table *spt, const void *start, const void *end);
+bool vma_populate(struct vma *vma, void *va);
+void vma_remove(struct supplemental_page_table *spt, struct vma *vma);
+bool vma_resize(struct supplemental_page_table *spt, struct vma *vma, void *new_end);
+bool vma_copy(struct supplemental_page_table *dst, struct supplemental_page_table *src);
+void vma_kill(struct supplemental_page_table *spt);
+void vma_heap_init(struct supplemental_page_table *spt);
+void *vma_sbrk(struct supplemental_page_table *spt, intptr_t increment);
+
+#endif
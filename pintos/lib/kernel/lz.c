@@ -0,0 +1,159 @@
+#include "lz.h"
+#include <debug.h>
+#include <string.h>
+
+/* Reads four bytes at P, which need not be aligned. */
+static uint32_t read32(const uint8_t *p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof v);
+	return v;
+}
+
+/* Hashes the four bytes in V into an index into the match
+   table. */
+static size_t hash32(uint32_t v)
+{
+	return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/* Writes LEN as a run of length bytes at OP: 255 for each full
+   255, then the remainder.  Returns the byte after the run. */
+static uint8_t *put_length(uint8_t *op, size_t len)
+{
+	for (; len >= 255; len -= 255)
+		*op++ = 255;
+	*op++ = len;
+	return op;
+}
+
+/* Reads a run of length bytes at *IP, not past END, and adds it
+   to *LEN.  Returns false if the run is truncated. */
+static bool get_length(const uint8_t **ip, const uint8_t *end, size_t *len)
+{
+	uint8_t b;
+	do {
+		if (*ip >= end)
+			return false;
+		b = *(*ip)++;
+		*len += b;
+	} while (b == 255);
+	return true;
+}
+
+/* Writes a sequence of LIT_CNT literals at LIT followed by a
+   match of MATCH_LEN bytes at distance OFFSET to OP, not past
+   END.  A MATCH_LEN of 0 writes the final, literal-only
+   sequence.  Returns the byte after the sequence, or a null
+   pointer if it does not fit. */
+static uint8_t *put_sequence(uint8_t *op, uint8_t *end, const uint8_t *lit, size_t lit_cnt,
+							 size_t offset, size_t match_len)
+{
+	size_t ml = match_len > 0 ? match_len - LZ_MIN_MATCH : 0;
+	size_t need = 1 + lit_cnt / 255 + 1 + lit_cnt + 2 + ml / 255 + 1;
+	if (need > (size_t)(end - op))
+		return NULL;
+
+	*op++ = (lit_cnt < 15 ? lit_cnt : 15) << 4 | (ml < 15 ? ml : 15);
+	if (lit_cnt >= 15)
+		op = put_length(op, lit_cnt - 15);
+	memcpy(op, lit, lit_cnt);
+	op += lit_cnt;
+	if (match_len == 0)
+		return op;
+
+	*op++ = offset & 0xff;
+	*op++ = offset >> 8;
+	if (ml >= 15)
+		op = put_length(op, ml - 15);
+	return op;
+}
+
+/* Compresses the SRC_LEN bytes at SRC into DST, which has room
+   for DST_CAP bytes.  TABLE is scratch space for LZ_HASH_SIZE
+   entries, so that callers with small stacks can supply it.
+   Returns the compressed size, or 0 if the result would not fit
+   in DST_CAP bytes. */
+size_t lz_compress(const void *src_, size_t src_len, void *dst_, size_t dst_cap, uint16_t *table)
+{
+	const uint8_t *src = src_;
+	const uint8_t *end = src + src_len;
+	const uint8_t *ip = src;
+	const uint8_t *anchor = src;
+	uint8_t *dst = dst_;
+	uint8_t *op = dst;
+	uint8_t *op_end = dst + dst_cap;
+
+	ASSERT(src_len <= LZ_MAX_INPUT);
+
+	memset(table, 0, LZ_HASH_SIZE * sizeof *table);
+	while (end - ip >= LZ_MIN_MATCH) {
+		uint32_t seq = read32(ip);
+		size_t h = hash32(seq);
+		const uint8_t *ref = src + table[h];
+
+		table[h] = ip - src;
+		if (ref >= ip || read32(ref) != seq) {
+			ip++;
+			continue;
+		}
+
+		const uint8_t *mp = ip + LZ_MIN_MATCH;
+		const uint8_t *rp = ref + LZ_MIN_MATCH;
+		while (mp < end && *mp == *rp)
+			mp++, rp++;
+
+		op = put_sequence(op, op_end, anchor, ip - anchor, ip - ref, mp - ip);
+		if (op == NULL)
+			return 0;
+		ip = anchor = mp;
+	}
+
+	op = put_sequence(op, op_end, anchor, end - anchor, 0, 0);
+	return op != NULL ? (size_t)(op - dst) : 0;
+}
+
+/* Decompresses the SRC_LEN bytes at SRC, which lz_compress()
+   produced, into the DST_LEN bytes at DST.  Returns true if the
+   block decodes to exactly DST_LEN bytes, false if it is
+   corrupt. */
+bool lz_decompress(const void *src, size_t src_len, void *dst, size_t dst_len)
+{
+	const uint8_t *ip = src;
+	const uint8_t *ip_end = ip + src_len;
+	uint8_t *op = dst;
+	uint8_t *op_end = op + dst_len;
+
+	while (ip < ip_end) {
+		uint8_t token = *ip++;
+
+		size_t lit_cnt = token >> 4;
+		if (lit_cnt == 15 && !get_length(&ip, ip_end, &lit_cnt))
+			return false;
+		if (lit_cnt > (size_t)(ip_end - ip) || lit_cnt > (size_t)(op_end - op))
+			return false;
+		memcpy(op, ip, lit_cnt);
+		ip += lit_cnt;
+		op += lit_cnt;
+		if (ip == ip_end)
+			break;
+
+		if (ip_end - ip < 2)
+			return false;
+		size_t offset = ip[0] | ip[1] << 8;
+		ip += 2;
+		size_t match_len = token & 15;
+		if (match_len == 15 && !get_length(&ip, ip_end, &match_len))
+			return false;
+		match_len += LZ_MIN_MATCH;
+		if (offset == 0 || offset > (size_t)(op - (uint8_t *)dst)
+			|| match_len > (size_t)(op_end - op))
+			return false;
+
+		/* Byte by byte, since the match may overlap its own output. */
+		const uint8_t *ref = op - offset;
+		while (match_len-- > 0)
+			*op++ = *ref++;
+	}
+	return op == op_end;
+}
@@ -0,0 +1,262 @@
+#include <malloc.h>
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+
+/* A size-class malloc() for user programs.
+
+   Requests of up to 1 kB are rounded up to a power of 2 and
+   served from the free list of that size class.  When the list
+   is empty, a new page of heap, called an "arena", is obtained
+   with sbrk() and divided into blocks, all of which are pushed
+   onto the free list.  free() pushes a block back onto its
+   list.  Arenas are never given back, so in the steady state
+   malloc() and free() are a list pop and a list push.
+
+   Larger requests get a run of whole pages with the page count
+   in the arena header.  Freed runs go onto a first-fit list to
+   be reused, except that a run at the very top of the heap is
+   returned to the kernel with sbrk().
+
+   The kernel fills heap pages with zeros the first time they
+   are touched, so memory that is allocated but never written
+   takes no frames. */
+
+#define PGSIZE 4096
+
+/* Magic number for detecting arena corruption. */
+#define ARENA_MAGIC 0x6d616c6c
+
+/* Size classes: 16, 32, ..., 1024 bytes. */
+#define CLASS_CNT 7
+#define BIG_CLASS CLASS_CNT
+
+/* Arena.  Occupies the start of each page of small blocks and
+   of each run of pages for a big block. */
+struct arena {
+	unsigned magic;	 /* Always set to ARENA_MAGIC. */
+	unsigned class;	 /* Size class, or BIG_CLASS for a big block. */
+	size_t page_cnt; /* Pages in a big block, 1 for small blocks. */
+};
+
+/* Free block. */
+struct block {
+	struct block *next; /* Next free block in the same class. */
+};
+
+/* Free big blocks, linked through their first word. */
+struct big_block {
+	struct arena *next; /* Next free big block. */
+};
+
+static struct block *free_lists[CLASS_CNT];
+static struct arena *big_free;
+
+/* Returns the size of the blocks in CLASS. */
+static size_t class_size(unsigned class)
+{
+	return (size_t)16 << class;
+}
+
+/* Returns the arena that block B belongs to. */
+static struct arena *block_to_arena(void *b)
+{
+	struct arena *a = (struct arena *)((uintptr_t)b & ~(uintptr_t)(PGSIZE - 1));
+
+	/* A big block starts right after its arena header, so the
+	   header is in the same page. */
+	ASSERT(a->magic == ARENA_MAGIC);
+	ASSERT(a->class <= BIG_CLASS);
+	return a;
+}
+
+/* Obtains PAGE_CNT pages from the top of the heap, page-aligning
+   the break first in case someone else moved it.  Returns a null
+   pointer if the heap cannot grow. */
+static void *get_pages(size_t page_cnt)
+{
+	uint8_t *top = sbrk(0);
+	size_t pad = ROUND_UP((uintptr_t)top, PGSIZE) - (uintptr_t)top;
+
+	if (sbrk(pad + page_cnt * PGSIZE) == (void *)-1)
+		return NULL;
+	return top + pad;
+}
+
+/* Allocates a big block of at least SIZE bytes. */
+static void *big_alloc(size_t size)
+{
+	size_t page_cnt = DIV_ROUND_UP(size + sizeof(struct arena), PGSIZE);
+	struct arena **ap, *a;
+
+	/* Reuse the first free run that is large enough, splitting off
+	   whatever it has left over. */
+	for (ap = &big_free; *ap != NULL; ap = &((struct big_block *)(*ap + 1))->next) {
+		a = *ap;
+		if (a->page_cnt < page_cnt)
+			continue;
+
+		*ap = ((struct big_block *)(a + 1))->next;
+		if (a->page_cnt > page_cnt) {
+			struct arena *rest = (struct arena *)((uint8_t *)a + page_cnt * PGSIZE);
+			rest->magic = ARENA_MAGIC;
+			rest->class = BIG_CLASS;
+			rest->page_cnt = a->page_cnt - page_cnt;
+			((struct big_block *)(rest + 1))->next = big_free;
+			big_free = rest;
+			a->page_cnt = page_cnt;
+		}
+		return a + 1;
+	}
+
+	a = get_pages(page_cnt);
+	if (a == NULL)
+		return NULL;
+	a->magic = ARENA_MAGIC;
+	a->class = BIG_CLASS;
+	a->page_cnt = page_cnt;
+	return a + 1;
+}
+
+/* Frees big block A, giving it back to the kernel if it is at the
+   top of the heap. */
+static void big_free_arena(struct arena *a)
+{
+	size_t size = a->page_cnt * PGSIZE;
+
+	if ((uint8_t *)a + size == sbrk(0)) {
+		a->magic = 0;
+		sbrk(-(intptr_t)size);
+		return;
+	}
+	((struct big_block *)(a + 1))->next = big_free;
+	big_free = a;
+}
+
+/* Obtains and returns a new block of at least SIZE bytes.
+   Returns a null pointer if memory is not available. */
+void *malloc(size_t size)
+{
+	unsigned class;
+	struct block *b;
+
+	/* A null pointer satisfies a request for 0 bytes. */
+	if (size == 0)
+		return NULL;
+
+	for (class = 0; class < CLASS_CNT; class++)
+		if (class_size(class) >= size)
+			break;
+	if (class == CLASS_CNT)
+		return big_alloc(size);
+
+	/* If the free list is empty, carve a new arena into blocks. */
+	if (free_lists[class] == NULL) {
+		size_t block_size = class_size(class);
+		struct arena *a = get_pages(1);
+		uint8_t *p;
+
+		if (a == NULL)
+			return NULL;
+		a->magic = ARENA_MAGIC;
+		a->class = class;
+		a->page_cnt = 1;
+
+		/* Blocks start after the header; push them in reverse so the
+		   lowest address is handed out first. */
+		for (p = (uint8_t *)a + PGSIZE - block_size; p >= (uint8_t *)(a + 1); p -= block_size) {
+			b = (struct block *)p;
+			b->next = free_lists[class];
+			free_lists[class] = b;
+		}
+	}
+
+	b = free_lists[class];
+	free_lists[class] = b->next;
+	return b;
+}
+
+/* Allocates and returns A times B bytes initialized to zeros.
+   Returns a null pointer if memory is not available. */
+void *calloc(size_t a, size_t b)
+{
+	void *p;
+	size_t size;
+
+	/* Calculate block size and make sure it fits in size_t. */
+	size = a * b;
+	if (b != 0 && size / b != a)
+		return NULL;
+
+	/* Allocate and zero memory. */
+	p = malloc(size);
+	if (p != NULL)
+		memset(p, 0, size);
+
+	return p;
+}
+
+/* Returns the number of bytes allocated for BLOCK. */
+static size_t block_size(void *block)
+{
+	struct arena *a = block_to_arena(block);
+
+	if (a->class == BIG_CLASS)
+		return a->page_cnt * PGSIZE - sizeof *a;
+	return class_size(a->class);
+}
+
+/* Attempts to resize OLD_BLOCK to NEW_SIZE bytes, possibly
+   moving it in the process.
+   If successful, returns the new block; on failure, returns a
+   null pointer.
+   A call with null OLD_BLOCK is equivalent to malloc(NEW_SIZE).
+   A call with zero NEW_SIZE is equivalent to free(OLD_BLOCK). */
+void *realloc(void *old_block, size_t new_size)
+{
+	if (new_size == 0) {
+		free(old_block);
+		return NULL;
+	}
+	if (old_block == NULL)
+		return malloc(new_size);
+
+	/* The block already has room. */
+	size_t old_size = block_size(old_block);
+	if (new_size <= old_size)
+		return old_block;
+
+	void *new_block = malloc(new_size);
+	if (new_block != NULL) {
+		memcpy(new_block, old_block, old_size);
+		free(old_block);
+	}
+	return new_block;
+}
+
+/* Frees block P, which must have been previously allocated with
+   malloc(), calloc(), or realloc(). */
+void free(void *p)
+{
+	struct arena *a;
+	struct block *b = p;
+
+	if (p == NULL)
+		return;
+
+	a = block_to_arena(p);
+	if (a->class == BIG_CLASS) {
+		big_free_arena(a);
+		return;
+	}
+
+#ifndef NDEBUG
+	/* Clear the block to help detect use-after-free bugs. */
+	memset(b, 0xcc, class_size(a->class));
+#endif
+
+	b->next = free_lists[a->class];
+	free_lists[a->class] = b;
+}
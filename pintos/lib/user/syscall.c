@@ -46,7 +46,7 @@ __attribute__((always_inline)) static __inline int64_t syscall(uint64_t num_, ui
 	(syscall(((uint64_t)NUMBER), ((uint64_t)ARG0), ((uint64_t)ARG1), ((uint64_t)ARG2), 0, 0, 0))
 
 #define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3)                                                   \
-	(syscall(((uint64_t *)NUMBER), ((uint64_t)ARG0), ((uint64_t)ARG1), ((uint64_t)ARG2),           \
+	(syscall(((uint64_t)NUMBER), ((uint64_t)ARG0), ((uint64_t)ARG1), ((uint64_t)ARG2),             \
 			 ((uint64_t)ARG3), 0, 0))
 
 #define syscall5(NUMBER, ARG0, ARG1, ARG2, ARG3, ARG4)                                             \
@@ -139,6 +139,46 @@ void munmap(void *addr)
 	syscall1(SYS_MUNMAP, addr);
 }
 
+int msync(void *addr, size_t length, int flags)
+{
+	return syscall3(SYS_MSYNC, addr, length, flags);
+}
+
+int madvise(void *addr, size_t length, int advice)
+{
+	return syscall3(SYS_MADVISE, addr, length, advice);
+}
+
+void memstat(struct memstat *stat)
+{
+	syscall1(SYS_MEMSTAT, stat);
+}
+
+void *sbrk(intptr_t increment)
+{
+	return (void *)syscall1(SYS_SBRK, increment);
+}
+
+int pread(int fd, void *buffer, unsigned size, off_t offset)
+{
+	return syscall4(SYS_PREAD, fd, buffer, size, offset);
+}
+
+int pwrite(int fd, const void *buffer, unsigned size, off_t offset)
+{
+	return syscall4(SYS_PWRITE, fd, buffer, size, offset);
+}
+
+int readv(int fd, const struct iovec *iov, int iovcnt)
+{
+	return syscall3(SYS_READV, fd, iov, iovcnt);
+}
+
+int writev(int fd, const struct iovec *iov, int iovcnt)
+{
+	return syscall3(SYS_WRITEV, fd, iov, iovcnt);
+}
+
 bool chdir(const char *dir)
 {
 	return syscall1(SYS_CHDIR, dir);
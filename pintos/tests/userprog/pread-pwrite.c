@@ -0,0 +1,39 @@
+/* Reads "sample.txt" with pread() at several offsets and checks
+   that the file position does not move, then overwrites part of
+   the file with pwrite() and reads it back. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  char buf[sizeof sample];
+  size_t size = sizeof sample - 1;
+  size_t ofs, len;
+  int handle;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+
+  for (ofs = 0; ofs < size; ofs += 100)
+    {
+      len = size - ofs < 64 ? size - ofs : 64;
+      if (pread (handle, buf, len, ofs) != (int) len)
+        fail ("pread() of %zu bytes at offset %zu failed", len, ofs);
+      if (memcmp (buf, sample + ofs, len))
+        fail ("pread() at offset %zu read the wrong data", ofs);
+    }
+  msg ("pread at several offsets");
+  CHECK (tell (handle) == 0, "file position did not move");
+
+  CHECK (pwrite (handle, "KAIST", 5, 100) == 5, "pwrite 5 bytes at offset 100");
+  CHECK (tell (handle) == 0, "file position did not move");
+  CHECK (pread (handle, buf, 5, 100) == 5 && !memcmp (buf, "KAIST", 5),
+         "pread them back");
+  CHECK (pread (handle, buf, 10, size) == 0, "pread at end of file");
+  CHECK (pread (handle, buf, 10, -1) == -1, "pread at negative offset");
+  CHECK (pread (0, buf, 10, 0) == -1, "pread from stdin");
+}
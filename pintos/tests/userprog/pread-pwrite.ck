@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pread-pwrite) begin
+(pread-pwrite) open "sample.txt"
+(pread-pwrite) pread at several offsets
+(pread-pwrite) file position did not move
+(pread-pwrite) pwrite 5 bytes at offset 100
+(pread-pwrite) file position did not move
+(pread-pwrite) pread them back
+(pread-pwrite) pread at end of file
+(pread-pwrite) pread at negative offset
+(pread-pwrite) pread from stdin
+(pread-pwrite) end
+pread-pwrite: exit(0)
+EOF
+pass;
@@ -0,0 +1,57 @@
+/* Writes a file in pieces with writev(), reads it back in other
+   pieces with readv(), and prints a line assembled from several
+   buffers with one writev() to the console. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[sizeof sample];
+
+void
+test_main (void) 
+{
+  struct iovec iov[4];
+  size_t size = sizeof sample - 1;
+  int handle, written;
+
+  CHECK (create ("test.txt", size), "create \"test.txt\"");
+  CHECK ((handle = open ("test.txt")) > 1, "open \"test.txt\"");
+
+  iov[0].iov_base = sample;
+  iov[0].iov_len = 10;
+  iov[1].iov_base = sample + 10;
+  iov[1].iov_len = 0;
+  iov[2].iov_base = sample + 10;
+  iov[2].iov_len = 300;
+  iov[3].iov_base = sample + 310;
+  iov[3].iov_len = size - 310;
+  CHECK (writev (handle, iov, 4) == (int) size, "writev 4 pieces");
+  CHECK (tell (handle) == size, "file position moved to end");
+
+  seek (handle, 0);
+  iov[0].iov_base = buf;
+  iov[0].iov_len = 1;
+  iov[1].iov_base = buf + 1;
+  iov[1].iov_len = size - 1;
+  iov[2].iov_base = buf + size;
+  iov[2].iov_len = 1;
+  CHECK (readv (handle, iov, 3) == (int) size, "readv 3 pieces up to end of file");
+  if (memcmp (buf, sample, size))
+    fail ("readv() read the wrong data");
+  CHECK (readv (handle, iov, -1) == -1, "readv with negative count");
+
+  iov[0].iov_base = "(readv-writev) ";
+  iov[0].iov_len = 15;
+  iov[1].iov_base = "assembled ";
+  iov[1].iov_len = 10;
+  iov[2].iov_base = "line\n";
+  iov[2].iov_len = 5;
+
+  /* CHECK prints its message before evaluating its condition, so
+     write the line first to keep it ahead of that message. */
+  written = writev (1, iov, 3);
+  CHECK (written == 30, "writev to the console");
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(readv-writev) begin
+(readv-writev) create "test.txt"
+(readv-writev) open "test.txt"
+(readv-writev) writev 4 pieces
+(readv-writev) file position moved to end
+(readv-writev) readv 3 pieces up to end of file
+(readv-writev) readv with negative count
+(readv-writev) assembled line
+(readv-writev) writev to the console
+(readv-writev) end
+readv-writev: exit(0)
+EOF
+pass;
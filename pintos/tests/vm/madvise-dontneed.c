@@ -0,0 +1,38 @@
+/* Touches anonymous pages, drops them with MADV_DONTNEED, and
+   checks that the process holds fewer frames afterward and that
+   the pages read back as zeros.  The frame count comes from the
+   memstat() test hook, so this test needs a kernel built without
+   NDEBUG. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 64
+
+static char buf[PAGE_CNT * PAGE_SIZE] __attribute__ ((aligned (PAGE_SIZE)));
+
+void
+test_main (void)
+{
+  struct memstat before, after;
+  size_t i;
+
+  memset (buf, 'x', sizeof buf);
+  memstat (&before);
+
+  CHECK (madvise (buf, sizeof buf, MADV_DONTNEED) == 0, "madvise MADV_DONTNEED");
+  memstat (&after);
+  if (before.rss < after.rss + PAGE_CNT)
+    fail ("rss went from %zu to %zu frames (should drop by at least %d)",
+          before.rss, after.rss, PAGE_CNT);
+  msg ("rss dropped");
+
+  for (i = 0; i < sizeof buf; i++)
+    if (buf[i] != 0)
+      fail ("byte %zu has value %02hhx after MADV_DONTNEED (should be 0)",
+            i, buf[i]);
+  msg ("pages read back as zeros");
+}
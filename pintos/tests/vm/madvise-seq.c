@@ -0,0 +1,49 @@
+/* Reads a file through one mapping advised MADV_SEQUENTIAL and
+   one advised MADV_RANDOM, checks both against read(), and
+   checks that madvise() rejects memory that is not mapped. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 64
+#define LENGTH (PAGE_CNT * PAGE_SIZE)
+
+void
+test_main (void)
+{
+  char *seq = (char *) 0x10000000;
+  char *rnd = (char *) 0x20000000;
+  char buf[PAGE_SIZE];
+  int handle;
+  size_t i;
+
+  CHECK ((handle = open ("large.txt")) > 1, "open \"large.txt\"");
+  CHECK (mmap (seq, LENGTH, 0, handle, 0) == seq, "mmap \"large.txt\"");
+  CHECK (mmap (rnd, LENGTH, 0, handle, 0) == rnd, "mmap \"large.txt\" again");
+  CHECK (madvise (seq, LENGTH, MADV_SEQUENTIAL) == 0, "madvise MADV_SEQUENTIAL");
+  CHECK (madvise (rnd, LENGTH, MADV_RANDOM) == 0, "madvise MADV_RANDOM");
+
+  for (i = 0; i < PAGE_CNT; i++)
+    {
+      if (read (handle, buf, PAGE_SIZE) != PAGE_SIZE)
+        fail ("read of page %zu failed", i);
+      if (memcmp (seq + i * PAGE_SIZE, buf, PAGE_SIZE))
+        fail ("page %zu of sequential mapping has bad data", i);
+    }
+  msg ("sequential mapping matches");
+
+  for (i = PAGE_CNT; i-- > 0; )
+    if (memcmp (rnd + i * PAGE_SIZE, seq + i * PAGE_SIZE, PAGE_SIZE))
+      fail ("page %zu of random mapping has bad data", i);
+  msg ("random mapping matches");
+
+  CHECK (madvise ((void *) 0x30000000, PAGE_SIZE, MADV_WILLNEED) == -1,
+         "madvise unmapped memory");
+
+  munmap (seq);
+  munmap (rnd);
+  close (handle);
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(madvise-seq) begin
+(madvise-seq) open "large.txt"
+(madvise-seq) mmap "large.txt"
+(madvise-seq) mmap "large.txt" again
+(madvise-seq) madvise MADV_SEQUENTIAL
+(madvise-seq) madvise MADV_RANDOM
+(madvise-seq) sequential mapping matches
+(madvise-seq) random mapping matches
+(madvise-seq) madvise unmapped memory
+(madvise-seq) end
+EOF
+pass;
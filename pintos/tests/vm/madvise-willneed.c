@@ -0,0 +1,46 @@
+/* Advises MADV_WILLNEED on a file mapping and checks that every
+   page of the mapping still matches the file, whether it was
+   prefetched in the background or faulted in.  Then advises a
+   second mapping and unmaps it at once, while the prefetch may
+   still be queued. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define LENGTH (32 * PAGE_SIZE)
+
+static char buf[LENGTH];
+
+void
+test_main (void)
+{
+  char *hinted = (char *) 0x10000000;
+  char *dropped = (char *) 0x20000000;
+  int handle;
+
+  CHECK ((handle = open ("large.txt")) > 1, "open \"large.txt\"");
+  CHECK (read (handle, buf, LENGTH) == LENGTH, "read \"large.txt\"");
+
+  CHECK (mmap (hinted, LENGTH, 0, handle, 0) == hinted, "mmap \"large.txt\"");
+  CHECK (madvise (hinted, LENGTH, MADV_WILLNEED) == 0, "madvise MADV_WILLNEED");
+  if (memcmp (hinted, buf, LENGTH))
+    fail ("advised mapping differs from file");
+  msg ("advised mapping matches file");
+
+  CHECK (mmap (dropped, LENGTH, 0, handle, 0) == dropped,
+         "mmap \"large.txt\" again");
+  CHECK (madvise (dropped, LENGTH, MADV_WILLNEED) == 0,
+         "madvise MADV_WILLNEED again");
+  munmap (dropped);
+  msg ("unmapped advised mapping");
+
+  if (memcmp (hinted, buf, LENGTH))
+    fail ("advised mapping differs from file after unmap");
+  msg ("advised mapping still matches file");
+
+  munmap (hinted);
+  close (handle);
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(madvise-willneed) begin
+(madvise-willneed) open "large.txt"
+(madvise-willneed) read "large.txt"
+(madvise-willneed) mmap "large.txt"
+(madvise-willneed) madvise MADV_WILLNEED
+(madvise-willneed) advised mapping matches file
+(madvise-willneed) mmap "large.txt" again
+(madvise-willneed) madvise MADV_WILLNEED again
+(madvise-willneed) unmapped advised mapping
+(madvise-willneed) advised mapping still matches file
+(madvise-willneed) end
+EOF
+pass;
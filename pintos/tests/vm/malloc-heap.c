@@ -0,0 +1,72 @@
+/* Allocates blocks of many sizes with malloc(), fills each with
+   its own pattern, checks them all, frees them, and checks that
+   the heap can shrink back to where it started with sbrk() but
+   not below the heap's start. */
+
+#include <malloc.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define BLOCK_CNT 200
+
+static char *blocks[BLOCK_CNT];
+
+/* Size of block I: small blocks of every size class mixed with a
+   few blocks spanning several pages. */
+static size_t
+block_size (size_t i)
+{
+  return i % 10 == 9 ? 3 * 4096 + i : 1 + (i * 37) % 1024;
+}
+
+void
+test_main (void)
+{
+  char *top;
+  size_t i, j;
+
+  top = sbrk (0);
+  CHECK (top != (void *) -1, "sbrk (0)");
+
+  for (i = 0; i < BLOCK_CNT; i++)
+    {
+      blocks[i] = malloc (block_size (i));
+      if (blocks[i] == NULL)
+        fail ("malloc of block %zu failed", i);
+      memset (blocks[i], i, block_size (i));
+    }
+  msg ("allocated blocks");
+
+  for (i = 0; i < BLOCK_CNT; i++)
+    for (j = 0; j < block_size (i); j++)
+      if (blocks[i][j] != (char) i)
+        fail ("byte %zu of block %zu was overwritten", j, i);
+  msg ("blocks keep their data");
+
+  for (i = 0; i < BLOCK_CNT; i += 2)
+    free (blocks[i]);
+  for (i = 0; i < BLOCK_CNT; i += 2)
+    {
+      blocks[i] = calloc (1, block_size (i));
+      if (blocks[i] == NULL)
+        fail ("calloc of block %zu failed", i);
+      for (j = 0; j < block_size (i); j++)
+        if (blocks[i][j] != 0)
+          fail ("byte %zu of calloc'd block %zu is not zero", j, i);
+    }
+  msg ("reused freed blocks");
+
+  for (i = 0; i < BLOCK_CNT; i++)
+    free (blocks[i]);
+
+  CHECK (sbrk (4096) != (void *) -1, "grow heap by a page");
+  CHECK (sbrk (-4096) != (void *) -1, "shrink heap by a page");
+  CHECK (sbrk (top - (char *) sbrk (0)) != (void *) -1,
+         "shrink heap back to where it started");
+  CHECK (sbrk (0) == top, "heap ends where it started");
+
+  /* Asks for a break of address 0, which is below any heap. */
+  CHECK (sbrk (-(intptr_t) top) == (void *) -1, "shrink heap below its start");
+}
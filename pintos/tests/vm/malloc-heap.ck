@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(malloc-heap) begin
+(malloc-heap) sbrk (0)
+(malloc-heap) allocated blocks
+(malloc-heap) blocks keep their data
+(malloc-heap) reused freed blocks
+(malloc-heap) grow heap by a page
+(malloc-heap) shrink heap by a page
+(malloc-heap) shrink heap back to where it started
+(malloc-heap) heap ends where it started
+(malloc-heap) shrink heap below its start
+(malloc-heap) end
+EOF
+pass;
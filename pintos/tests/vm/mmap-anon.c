@@ -0,0 +1,39 @@
+/* Maps anonymous memory with fd -1, checks that it reads as
+   zeros and keeps what is written to it, and unmaps it. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define LENGTH (16 * 4096)
+
+void
+test_main (void)
+{
+  char *actual = (char *) 0x10000000;
+  size_t i;
+
+  CHECK (mmap (actual, LENGTH, 1, MAP_ANONYMOUS, 0) == actual,
+         "mmap anonymous memory");
+
+  for (i = 0; i < LENGTH; i++)
+    if (actual[i] != 0)
+      fail ("byte %zu of anonymous mapping has value %02hhx (should be 0)",
+            i, actual[i]);
+  msg ("anonymous mapping reads as zeros");
+
+  for (i = 0; i < LENGTH; i++)
+    actual[i] = i % 251;
+  for (i = 0; i < LENGTH; i++)
+    if (actual[i] != (char) (i % 251))
+      fail ("byte %zu of anonymous mapping was not kept", i);
+  msg ("anonymous mapping keeps data");
+
+  munmap (actual);
+  CHECK (mmap (actual, LENGTH, 1, MAP_ANONYMOUS, 0) == actual,
+         "mmap anonymous memory again");
+  if (actual[0] != 0)
+    fail ("new anonymous mapping kept old data");
+  msg ("new anonymous mapping is zeroed");
+}
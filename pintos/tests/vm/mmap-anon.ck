@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-anon) begin
+(mmap-anon) mmap anonymous memory
+(mmap-anon) anonymous mapping reads as zeros
+(mmap-anon) anonymous mapping keeps data
+(mmap-anon) mmap anonymous memory again
+(mmap-anon) new anonymous mapping is zeroed
+(mmap-anon) end
+EOF
+pass;
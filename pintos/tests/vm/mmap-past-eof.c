@@ -0,0 +1,43 @@
+/* Maps more pages than "sample.txt" holds, so that fault-around
+   prefetches pages lying past the end of the file, writes to one
+   of those pages, and unmaps.  The write past EOF must be dropped
+   without an error and without changing the file. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGES 4
+
+void
+test_main (void)
+{
+  char *actual = (char *) 0x10000000;
+  char buf[1024];
+  int handle;
+  void *map;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((map = mmap (actual, PAGES * 4096, 1, handle, 0)) != MAP_FAILED,
+         "mmap \"sample.txt\"");
+
+  /* The first access reads page 0 and prefetches the rest. */
+  if (memcmp (actual, sample, strlen (sample)))
+    fail ("read of mmap'd file reported bad data");
+
+  msg ("write to page past EOF");
+  actual[2 * 4096] = 'x';
+  if (actual[3 * 4096] != 0)
+    fail ("page past EOF is not zero-filled");
+
+  munmap (map);
+
+  CHECK (filesize (handle) == (int) strlen (sample), "file size unchanged");
+  CHECK (read (handle, buf, sizeof buf) == (int) strlen (sample),
+         "read \"sample.txt\"");
+  if (memcmp (buf, sample, strlen (sample)))
+    fail ("file contents changed after munmap");
+  close (handle);
+}
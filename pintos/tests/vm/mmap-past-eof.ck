@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-past-eof) begin
+(mmap-past-eof) open "sample.txt"
+(mmap-past-eof) mmap "sample.txt"
+(mmap-past-eof) write to page past EOF
+(mmap-past-eof) file size unchanged
+(mmap-past-eof) read "sample.txt"
+(mmap-past-eof) end
+EOF
+pass;
@@ -0,0 +1,45 @@
+/* Maps a large zero-filled array with 2 MB pages (kernel option
+   -hp) and then touches more memory than Pintos has, so that the
+   2 MB mappings are split when their pages are swapped out.
+   Checks that every page keeps what was written to it, and that
+   bytes never written are still zero. */
+
+#include <string.h>
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SHIFT 12
+#define PAGE_SIZE (1 << PAGE_SHIFT)
+#define ONE_MB (1 << 20)
+#define CHUNK_SIZE (12 * ONE_MB)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+
+static char big_chunk[CHUNK_SIZE];
+
+void
+test_main (void)
+{
+  size_t i;
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    {
+      char *mem = big_chunk + i * PAGE_SIZE;
+      if (i % 512 == 0)
+        msg ("write 2 MB stretch %zu", i / 512);
+      mem[0] = (char) i;
+      mem[PAGE_SIZE - 1] = (char) ~i;
+    }
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    {
+      char *mem = big_chunk + i * PAGE_SIZE;
+      if (mem[0] != (char) i || mem[PAGE_SIZE - 1] != (char) ~i)
+        fail ("page %zu lost its contents", i);
+      if (mem[PAGE_SIZE / 2] != 0)
+        fail ("page %zu is not zero where it was never written", i);
+      if (i % 512 == 0)
+        msg ("check 2 MB stretch %zu", i / 512);
+    }
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-huge) begin
+(swap-huge) write 2 MB stretch 0
+(swap-huge) write 2 MB stretch 1
+(swap-huge) write 2 MB stretch 2
+(swap-huge) write 2 MB stretch 3
+(swap-huge) write 2 MB stretch 4
+(swap-huge) write 2 MB stretch 5
+(swap-huge) check 2 MB stretch 0
+(swap-huge) check 2 MB stretch 1
+(swap-huge) check 2 MB stretch 2
+(swap-huge) check 2 MB stretch 3
+(swap-huge) check 2 MB stretch 4
+(swap-huge) check 2 MB stretch 5
+(swap-huge) end
+EOF
+pass;
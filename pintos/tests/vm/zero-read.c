@@ -0,0 +1,44 @@
+/* Reads every page of a large zero-initialized array and checks
+   that this barely grows the process's resident set, because
+   untouched anonymous pages are backed by the shared zero frame.
+   Then writes to the pages and checks that they get real frames.
+   Uses the memstat() test hook, so it needs a kernel built without
+   NDEBUG. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_CNT 256
+
+/* Frames the test itself may fault in along the way. */
+#define SLACK 16
+
+static char zeros[PAGE_CNT * PAGE_SIZE] __attribute__ ((aligned (PAGE_SIZE)));
+
+void
+test_main (void)
+{
+  struct memstat before, after;
+  size_t i;
+
+  memstat (&before);
+  for (i = 0; i < PAGE_CNT; i++)
+    if (zeros[i * PAGE_SIZE] != 0)
+      fail ("page %zu of array has value %02hhx (should be 0)",
+            i, zeros[i * PAGE_SIZE]);
+  memstat (&after);
+  if (after.rss > before.rss + SLACK)
+    fail ("reading %d zero pages took rss from %zu to %zu frames",
+          PAGE_CNT, before.rss, after.rss);
+  msg ("reading zero pages kept rss low");
+
+  for (i = 0; i < PAGE_CNT; i++)
+    zeros[i * PAGE_SIZE] = 1;
+  memstat (&after);
+  if (after.rss < before.rss + PAGE_CNT)
+    fail ("writing %d pages took rss only from %zu to %zu frames",
+          PAGE_CNT, before.rss, after.rss);
+  msg ("writing pages allocated frames");
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(zero-read) begin
+(zero-read) reading zero pages kept rss low
+(zero-read) writing pages allocated frames
+(zero-read) end
+EOF
+pass;
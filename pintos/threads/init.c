@@ -27,6 +27,7 @@
 #include "userprog/gdt.h"
 #include "userprog/syscall.h"
 #include "userprog/tss.h"
+#include "userprog/validate.h"
 #include "userprog/fd_util.h"
 #endif
 #include "tests/threads/tests.h"
@@ -230,6 +231,18 @@ static char **parse_options(char **argv)
 			user_page_limit = atoi(value);
 		else if (!strcmp(name, "-threads-tests"))
 			thread_tests = true;
+#endif
+#ifdef VM
+		else if (!strcmp(name, "-pl"))
+			vm_pageout_low = atoi(value);
+		else if (!strcmp(name, "-ph"))
+			vm_pageout_high = atoi(value);
+		else if (!strcmp(name, "-hp"))
+			vm_huge_pages = true;
+		else if (!strcmp(name, "-ws"))
+			vm_ws_report = true;
+		else if (!strcmp(name, "-zs"))
+			vm_zswap_pages = atoi(value);
 #endif
 		else
 			PANIC("unknown option `%s' (use -h for help)", name);
@@ -328,6 +341,13 @@ static void usage(void)
 		   "  -mlfqs             Use multi-level feedback queue scheduler.\n"
 #ifdef USERPROG
 		   "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+		   "  -pl=COUNT          Wake the pageout daemon below COUNT free frames.\n"
+		   "  -ph=COUNT          Let the pageout daemon reclaim up to COUNT free frames.\n"
+		   "  -hp                Map large anonymous regions with 2 MB pages.\n"
+		   "  -ws                Print working set size and fault rate at process exit.\n"
+		   "  -zs=COUNT          Keep up to COUNT pages of compressed swap in memory.\n"
 #endif
 	);
 	power_off();
@@ -356,10 +376,15 @@ static void print_stats(void)
 	thread_print_stats();
 #ifdef FILESYS
 	disk_print_stats();
+	rwlock_print_stats();
 #endif
 	console_print_stats();
 	kbd_print_stats();
 #ifdef USERPROG
 	exception_print_stats();
+	user_copy_print_stats();
+#endif
+#ifdef VM
+	vm_print_stats();
 #endif
 }
@@ -8,10 +8,31 @@
 #include "threads/mmu.h"
 #include "intrinsic.h"
 
+/* Replaces the 2 MB mapping in page-directory entry PDE, which
+ * covers VA, by a page table of 4 kB PTEs that map the same frames
+ * with the same flags, so that single pages can be changed.  If no
+ * page table can be allocated, the 2 MB mapping is removed
+ * instead: later accesses fault and the VM layer maps the pages
+ * one at a time. */
+static void pde_split(uint64_t *pde, const uint64_t va)
+{
+	uint64_t *pt = palloc_get_page(0);
+	if (pt) {
+		uint64_t flags = *pde & PTE_FLAGS & ~(uint64_t)PTE_PS;
+		for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++)
+			pt[i] = (PTE_ADDR(*pde) + i * PGSIZE) | flags;
+		*pde = vtop(pt) | PTE_U | PTE_W | PTE_P;
+	} else
+		*pde = 0;
+	invlpg(va & ~(HUGE_PGSIZE - 1));
+}
+
 static uint64_t *pgdir_walk(uint64_t *pdp, const uint64_t va, int create)
 {
 	int idx = PDX(va);
 	if (pdp) {
+		if ((pdp[idx] & (PTE_P | PTE_PS)) == (PTE_P | PTE_PS))
+			pde_split(&pdp[idx], va);
 		uint64_t *pte = (uint64_t *)pdp[idx];
 		if (!((uint64_t)pte & PTE_P)) {
 			if (create) {
@@ -88,6 +109,37 @@ uint64_t *pml4e_walk(uint64_t *pml4e, const uint64_t va, int create)
 	return pte;
 }
 
+/* Returns the address of the page-directory entry for VA in
+ * PML4, creating the upper-level tables if CREATE is true.
+ * Returns a null pointer if they are missing and CREATE is false,
+ * or if memory allocation fails. */
+static uint64_t *pde_walk(uint64_t *pml4, const uint64_t va, bool create)
+{
+	uint64_t *table = pml4;
+	const int idx[] = {PML4(va), PDPE(va)};
+
+	for (unsigned i = 0; i < sizeof idx / sizeof *idx; i++) {
+		if (!(table[idx[i]] & PTE_P)) {
+			uint64_t *new_page = create ? palloc_get_page(PAL_ZERO) : NULL;
+			if (new_page == NULL)
+				return NULL;
+			table[idx[i]] = vtop(new_page) | PTE_U | PTE_W | PTE_P;
+		}
+		table = ptov(PTE_ADDR(table[idx[i]]));
+	}
+	return &table[PDX(va)];
+}
+
+/* Returns the page-directory entry for VA in PML4 if VA is mapped
+ * by a 2 MB page, otherwise a null pointer. */
+static uint64_t *huge_pde(uint64_t *pml4, const void *va)
+{
+	uint64_t *pde = pde_walk(pml4, (uint64_t)va, false);
+	if (pde != NULL && (*pde & (PTE_P | PTE_PS)) == (PTE_P | PTE_PS))
+		return pde;
+	return NULL;
+}
+
 /* Creates a new page map level 4 (pml4) has mappings for kernel
  * virtual addresses, but none for user virtual addresses.
  * Returns the new page directory, or a null pointer if memory
@@ -121,7 +173,7 @@ static bool pgdir_for_each(uint64_t *pdp, pte_for_each_func *func, void *aux, un
 {
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *)pdp[i]);
-		if (((uint64_t)pte) & PTE_P)
+		if ((((uint64_t)pte) & PTE_P) && !(((uint64_t)pte) & PTE_PS))
 			if (!pt_for_each((uint64_t *)PTE_ADDR(pte), func, aux, pml4_index, pdp_index, i))
 				return false;
 	}
@@ -163,9 +215,11 @@ static void pt_destroy(uint64_t *pt)
 
 static void pgdir_destroy(uint64_t *pdp)
 {
+	/* Frames behind 2 MB mappings belong to the VM layer, which
+	   releases them page by page. */
 	for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++) {
 		uint64_t *pte = ptov((uint64_t *)pdp[i]);
-		if (((uint64_t)pte) & PTE_P)
+		if ((((uint64_t)pte) & PTE_P) && !(((uint64_t)pte) & PTE_PS))
 			pt_destroy(PTE_ADDR(pte));
 	}
 	palloc_free_page((void *)pdp);
@@ -210,6 +264,10 @@ void *pml4_get_page(uint64_t *pml4, const void *uaddr)
 {
 	ASSERT(is_user_vaddr(uaddr));
 
+	uint64_t *pde = huge_pde(pml4, uaddr);
+	if (pde)
+		return ptov(PTE_ADDR(*pde)) + ((uint64_t)uaddr & (HUGE_PGSIZE - 1));
+
 	uint64_t *pte = pml4e_walk(pml4, (uint64_t)uaddr, 0);
 
 	if (pte && (*pte & PTE_P))
@@ -239,6 +297,52 @@ bool pml4_set_page(uint64_t *pml4, void *upage, void *kpage, bool rw)
 	return pte != NULL;
 }
 
+/* Maps the 2 MB of user virtual memory at UPAGE to the physically
+ * contiguous frames at kernel virtual address KPAGE with a single
+ * page-directory entry.  Both must be 2 MB aligned, and no page in
+ * the range may be mapped yet.  The other functions here treat
+ * the range as 512 ordinary pages: queries and accessed-bit
+ * updates act on the shared entry, while any other change to a
+ * single page first splits it into 4 kB PTEs.
+ * Returns true if successful, false if memory allocation failed
+ * or part of the range is mapped. */
+bool pml4_set_huge_page(uint64_t *pml4, void *upage, void *kpage, bool rw)
+{
+	ASSERT(((uint64_t)upage & (HUGE_PGSIZE - 1)) == 0);
+	ASSERT(((uint64_t)kpage & (HUGE_PGSIZE - 1)) == 0);
+	ASSERT(is_user_vaddr(upage));
+	ASSERT(pml4 != base_pml4);
+
+	uint64_t *pde = pde_walk(pml4, (uint64_t)upage, true);
+	if (pde == NULL)
+		return false;
+
+	/* A page table left over from earlier 4 kB mappings is dropped
+	   if nothing in it is still present. */
+	if (*pde & PTE_P) {
+		if (*pde & PTE_PS)
+			return false;
+		uint64_t *pt = ptov(PTE_ADDR(*pde));
+		for (unsigned i = 0; i < PGSIZE / sizeof(uint64_t *); i++)
+			if (pt[i] & PTE_P)
+				return false;
+		palloc_free_page(pt);
+	}
+
+	*pde = vtop(kpage) | PTE_PS | PTE_P | (rw ? PTE_W : 0) | PTE_U;
+	if (rcr3() == vtop(pml4))
+		invlpg((uint64_t)upage);
+	return true;
+}
+
+/* Returns true if VPAGE in PML4 is currently mapped by a 2 MB
+ * page, so that its accessed and dirty bits are shared with the
+ * other 511 pages of the same mapping. */
+bool pml4_is_huge(uint64_t *pml4, const void *vpage)
+{
+	return huge_pde(pml4, vpage) != NULL;
+}
+
 /* Marks user virtual page UPAGE "not present" in page
  * directory PD.  Later accesses to the page will fault.  Other
  * bits in the page table entry are preserved.
@@ -264,7 +368,9 @@ void pml4_clear_page(uint64_t *pml4, void *upage)
  * Returns false if PML4 contains no PTE for VPAGE. */
 bool pml4_is_dirty(uint64_t *pml4, const void *vpage)
 {
-	uint64_t *pte = pml4e_walk(pml4, (uint64_t)vpage, false);
+	uint64_t *pte = huge_pde(pml4, vpage);
+	if (pte == NULL)
+		pte = pml4e_walk(pml4, (uint64_t)vpage, false);
 	return pte != NULL && (*pte & PTE_D) != 0;
 }
 
@@ -284,13 +390,32 @@ void pml4_set_dirty(uint64_t *pml4, const void *vpage, bool dirty)
 	}
 }
 
+/* Sets the writable bit to WRITABLE in the PTE for virtual page
+ * VPAGE in PML4.  Other bits in the PTE, including the accessed
+ * and dirty bits, are preserved. */
+void pml4_set_writable(uint64_t *pml4, const void *vpage, bool writable)
+{
+	uint64_t *pte = pml4e_walk(pml4, (uint64_t)vpage, false);
+	if (pte) {
+		if (writable)
+			*pte |= PTE_W;
+		else
+			*pte &= ~(uint64_t)PTE_W;
+
+		if (rcr3() == vtop(pml4))
+			invlpg((uint64_t)vpage);
+	}
+}
+
 /* Returns true if the PTE for virtual page VPAGE in PML4 has been
  * accessed recently, that is, between the time the PTE was
  * installed and the last time it was cleared.  Returns false if
  * PML4 contains no PTE for VPAGE. */
 bool pml4_is_accessed(uint64_t *pml4, const void *vpage)
 {
-	uint64_t *pte = pml4e_walk(pml4, (uint64_t)vpage, false);
+	uint64_t *pte = huge_pde(pml4, vpage);
+	if (pte == NULL)
+		pte = pml4e_walk(pml4, (uint64_t)vpage, false);
 	return pte != NULL && (*pte & PTE_A) != 0;
 }
 
@@ -298,7 +423,9 @@ bool pml4_is_accessed(uint64_t *pml4, const void *vpage)
    VPAGE in PD. */
 void pml4_set_accessed(uint64_t *pml4, const void *vpage, bool accessed)
 {
-	uint64_t *pte = pml4e_walk(pml4, (uint64_t)vpage, false);
+	uint64_t *pte = huge_pde(pml4, vpage);
+	if (pte == NULL)
+		pte = pml4e_walk(pml4, (uint64_t)vpage, false);
 	if (pte) {
 		if (accessed)
 			*pte |= PTE_A;
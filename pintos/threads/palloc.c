@@ -8,8 +8,10 @@
 #include <stdio.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 #include "threads/vaddr.h"
 
 /* Page allocator.  Hands out memory in page-size (or
@@ -26,11 +28,31 @@
    half to the user pool.  That should be huge overkill for the
    kernel pool, but that's just fine for demonstration purposes. */
 
+/* Number of pre-zeroed pages each pool keeps at most.
+
+   When there is nothing else to run, the idle thread takes free
+   pages out of a pool, clears them, and parks them in the pool's
+   zeroed[] stack (see palloc_prezero()).  A single-page PAL_ZERO
+   request is then served from that stack without a memset.  The
+   parked pages are still handed out to other requests once the
+   bitmap runs dry, so they never make an allocation fail.
+
+   The idle thread must never hold a pool's lock where it could be
+   preempted: it is not on the ready list, so a thread waiting for
+   the lock could not donate its priority to it.  That is why
+   zeroed[] is guarded by disabling interrupts instead of by the
+   lock, and why the idle thread touches used_map only within a
+   single interrupts-off section. */
+#define PREZERO_MAX 32
+
 /* A memory pool. */
 struct pool {
 	struct lock lock;		 /* Mutual exclusion. */
 	struct bitmap *used_map; /* Bitmap of free pages. */
 	uint8_t *base;			 /* Base of pool. */
+
+	void *zeroed[PREZERO_MAX]; /* Free pages already filled with zeros. */
+	size_t zeroed_cnt;		   /* Number of entries in zeroed[]. */
 };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -41,6 +63,9 @@ size_t user_page_limit = SIZE_MAX;
 static void init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t end);
 
 static bool page_from_pool(const struct pool *, void *page);
+static void *pop_zeroed(struct pool *);
+static void release_zeroed(struct pool *);
+static bool prezero_pool(struct pool *, size_t page_cnt);
 
 /* multiboot info */
 struct multiboot_info {
@@ -257,16 +282,63 @@ uint64_t palloc_init(void)
 void *palloc_get_multiple(enum palloc_flags flags, size_t page_cnt)
 {
 	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	void *pages = NULL;
+	bool zeroed = false;
 
 	lock_acquire(&pool->lock);
-	size_t page_idx = bitmap_scan_and_flip(pool->used_map, 0, page_cnt, false);
+	/* Zeroed single pages come from the pre-zeroed stack first. */
+	if (page_cnt == 1 && (flags & PAL_ZERO))
+		pages = pop_zeroed(pool);
+	if (pages != NULL)
+		zeroed = true;
+	else {
+		size_t page_idx = bitmap_scan_and_flip(pool->used_map, 0, page_cnt, false);
+		if (page_idx == BITMAP_ERROR) {
+			/* Out of free pages: fall back on the pre-zeroed ones. */
+			if (page_cnt == 1) {
+				pages = pop_zeroed(pool);
+				zeroed = pages != NULL;
+			} else {
+				release_zeroed(pool);
+				page_idx = bitmap_scan_and_flip(pool->used_map, 0, page_cnt, false);
+			}
+		}
+		if (page_idx != BITMAP_ERROR)
+			pages = pool->base + PGSIZE * page_idx;
+	}
 	lock_release(&pool->lock);
-	void *pages;
 
-	if (page_idx != BITMAP_ERROR)
-		pages = pool->base + PGSIZE * page_idx;
-	else
-		pages = NULL;
+	if (pages) {
+		if ((flags & PAL_ZERO) && !zeroed)
+			memset(pages, 0, PGSIZE * page_cnt);
+	} else {
+		if (flags & PAL_ASSERT)
+			PANIC("palloc_get: out of pages");
+	}
+
+	return pages;
+}
+
+/* Obtains PAGE_CNT contiguous free pages whose first page
+   number is a multiple of ALIGN_CNT, as needed for large-page
+   mappings.  Otherwise behaves like palloc_get_multiple(), except
+   that pre-zeroed pages are left alone: an aligned run rarely
+   fits around them, so only fully free runs are considered. */
+void *palloc_get_aligned(enum palloc_flags flags, size_t page_cnt, size_t align_cnt)
+{
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	size_t pool_cnt = bitmap_size(pool->used_map);
+	size_t page_idx = (align_cnt - pg_no(pool->base) % align_cnt) % align_cnt;
+	void *pages = NULL;
+
+	lock_acquire(&pool->lock);
+	for (; page_idx + page_cnt <= pool_cnt; page_idx += align_cnt)
+		if (bitmap_none(pool->used_map, page_idx, page_cnt)) {
+			bitmap_set_multiple(pool->used_map, page_idx, page_cnt, true);
+			pages = pool->base + PGSIZE * page_idx;
+			break;
+		}
+	lock_release(&pool->lock);
 
 	if (pages) {
 		if (flags & PAL_ZERO)
@@ -323,6 +395,87 @@ void palloc_free_page(void *page)
 	palloc_free_multiple(page, 1);
 }
 
+/* Fills the pools' pre-zeroed page stacks a few pages at a time.
+   Called by the idle thread, so it never sleeps or yields: a pool
+   whose lock is busy is simply skipped.  Returns true if any page
+   was zeroed, which means the caller may want to call again. */
+bool palloc_prezero(void)
+{
+	bool progress = prezero_pool(&user_pool, 4);
+	return prezero_pool(&kernel_pool, 4) || progress;
+}
+
+/* Moves up to PAGE_CNT free pages of POOL into its pre-zeroed
+   stack.  The pool lock is taken only with interrupts off, so the
+   idle thread is never preempted while holding it, and the memset
+   runs with interrupts on and no lock held. */
+static bool prezero_pool(struct pool *pool, size_t page_cnt)
+{
+	bool progress = false;
+
+	while (page_cnt-- > 0) {
+		size_t page_idx = BITMAP_ERROR;
+		enum intr_level old_level = intr_disable();
+		if (pool->zeroed_cnt < PREZERO_MAX && lock_try_acquire(&pool->lock)) {
+			page_idx = bitmap_scan_and_flip(pool->used_map, 0, 1, false);
+			lock_release(&pool->lock);
+		}
+		intr_set_level(old_level);
+		if (page_idx == BITMAP_ERROR)
+			break;
+
+		void *page = pool->base + PGSIZE * page_idx;
+		memset(page, 0, PGSIZE);
+
+		/* Only the idle thread pushes, and others only pop, so the
+		   slot seen free above is still free. */
+		old_level = intr_disable();
+		ASSERT(pool->zeroed_cnt < PREZERO_MAX);
+		pool->zeroed[pool->zeroed_cnt++] = page;
+		intr_set_level(old_level);
+		progress = true;
+	}
+	return progress;
+}
+
+/* Pops a page off POOL's pre-zeroed stack and returns it, or
+   returns a null pointer if the stack is empty. */
+static void *pop_zeroed(struct pool *pool)
+{
+	void *page = NULL;
+	enum intr_level old_level = intr_disable();
+	if (pool->zeroed_cnt > 0)
+		page = pool->zeroed[--pool->zeroed_cnt];
+	intr_set_level(old_level);
+	return page;
+}
+
+/* Returns all of POOL's pre-zeroed pages to its free bitmap, so
+   that a multi-page request can use them.  POOL's lock must be
+   held. */
+static void release_zeroed(struct pool *pool)
+{
+	ASSERT(lock_held_by_current_thread(&pool->lock));
+
+	void *page;
+	while ((page = pop_zeroed(pool)) != NULL)
+		bitmap_reset(pool->used_map, pg_no(page) - pg_no(pool->base));
+}
+
+/* Returns the kernel virtual address of the first page in the
+   user pool.  Together with palloc_user_pool_size(), this lets
+   the VM subsystem index per-frame data by user page number. */
+void *palloc_user_pool_base(void)
+{
+	return user_pool.base;
+}
+
+/* Returns the number of pages managed by the user pool. */
+size_t palloc_user_pool_size(void)
+{
+	return bitmap_size(user_pool.used_map);
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void init_pool(struct pool *p, void **bm_base, uint64_t start, uint64_t end)
 {
@@ -36,6 +36,12 @@
 
 #define MAX_DEPTH 8
 
+/* Readers-writer lock statistics, for rwlock_print_stats(). */
+static long long rwlock_read_cnt;	/* Acquisitions for reading. */
+static long long rwlock_shared_cnt; /* ...that joined a reader already inside. */
+static long long rwlock_write_cnt;	/* Acquisitions for writing. */
+static long long rwlock_wait_cnt;	/* Acquisitions of either kind that slept. */
+
 static bool cond_insert_by_priority(struct list_elem *current, struct list_elem *e2,
 									void *aux UNUSED);
 static bool donor_higher_priority(struct list_elem *e1, struct list_elem *e2, void *aux UNUSED);
@@ -365,6 +371,119 @@ void cond_broadcast(struct condition *cond, struct lock *lock)
 		cond_signal(cond, lock);
 }
 
+/* Initializes RWLOCK.  See struct rwlock for how readers and
+   writers share it. */
+void rwlock_init(struct rwlock *rwlock)
+{
+	ASSERT(rwlock != NULL);
+
+	lock_init(&rwlock->lock);
+	cond_init(&rwlock->can_read);
+	cond_init(&rwlock->can_write);
+	rwlock->readers = 0;
+	rwlock->waiting_writers = 0;
+	rwlock->writer = NULL;
+}
+
+/* Acquires RWLOCK for reading, sleeping while a writer holds it
+   or is waiting for it.  A thread must not acquire RWLOCK again
+   while it already holds it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void rwlock_acquire_read(struct rwlock *rwlock)
+{
+	ASSERT(rwlock != NULL);
+	ASSERT(!intr_context());
+
+	lock_acquire(&rwlock->lock);
+	ASSERT(rwlock->writer != thread_current());
+	bool waited = false;
+	while (rwlock->writer != NULL || rwlock->waiting_writers > 0) {
+		waited = true;
+		cond_wait(&rwlock->can_read, &rwlock->lock);
+	}
+	if (waited)
+		rwlock_wait_cnt++;
+	rwlock_read_cnt++;
+	if (rwlock->readers > 0)
+		rwlock_shared_cnt++;
+	rwlock->readers++;
+	lock_release(&rwlock->lock);
+}
+
+/* Releases RWLOCK, which the current thread holds for reading. */
+void rwlock_release_read(struct rwlock *rwlock)
+{
+	ASSERT(rwlock != NULL);
+
+	lock_acquire(&rwlock->lock);
+	ASSERT(rwlock->readers > 0);
+	if (--rwlock->readers == 0)
+		cond_signal(&rwlock->can_write, &rwlock->lock);
+	lock_release(&rwlock->lock);
+}
+
+/* Acquires RWLOCK for writing, sleeping until no reader or other
+   writer holds it.  A thread must not acquire RWLOCK again while
+   it already holds it.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void rwlock_acquire_write(struct rwlock *rwlock)
+{
+	ASSERT(rwlock != NULL);
+	ASSERT(!intr_context());
+
+	lock_acquire(&rwlock->lock);
+	ASSERT(rwlock->writer != thread_current());
+	rwlock->waiting_writers++;
+	bool waited = false;
+	while (rwlock->writer != NULL || rwlock->readers > 0) {
+		waited = true;
+		cond_wait(&rwlock->can_write, &rwlock->lock);
+	}
+	if (waited)
+		rwlock_wait_cnt++;
+	rwlock_write_cnt++;
+	rwlock->waiting_writers--;
+	rwlock->writer = thread_current();
+	lock_release(&rwlock->lock);
+}
+
+/* Releases RWLOCK, which the current thread holds for writing.
+   Hands it to the next waiting writer if there is one, otherwise
+   to all waiting readers. */
+void rwlock_release_write(struct rwlock *rwlock)
+{
+	ASSERT(rwlock != NULL);
+
+	lock_acquire(&rwlock->lock);
+	ASSERT(rwlock_held_for_write(rwlock));
+	rwlock->writer = NULL;
+	if (rwlock->waiting_writers > 0)
+		cond_signal(&rwlock->can_write, &rwlock->lock);
+	else
+		cond_broadcast(&rwlock->can_read, &rwlock->lock);
+	lock_release(&rwlock->lock);
+}
+
+/* Prints readers-writer lock statistics. */
+void rwlock_print_stats(void)
+{
+	printf("RW locks: %lld reads (%lld alongside another reader), %lld writes, %lld waited\n",
+		   rwlock_read_cnt, rwlock_shared_cnt, rwlock_write_cnt, rwlock_wait_cnt);
+}
+
+/* Returns true if the current thread holds RWLOCK for writing,
+   false otherwise. */
+bool rwlock_held_for_write(const struct rwlock *rwlock)
+{
+	ASSERT(rwlock != NULL);
+
+	return rwlock->writer == thread_current();
+}
+
 static bool cond_insert_by_priority(struct list_elem *cur UNUSED, struct list_elem *e,
 									void *aux UNUSED)
 {
@@ -465,6 +465,20 @@ int thread_get_recent_cpu(void)
 	return recent;
 }
 
+/* Invokes function 'func' on all threads, passing along 'aux'.
+   This function must be called with interrupts off. */
+void thread_foreach(thread_action_func *func, void *aux)
+{
+	struct list_elem *e;
+
+	ASSERT(intr_get_level() == INTR_OFF);
+
+	for (e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e)) {
+		struct thread *t = list_entry(e, struct thread, allelem);
+		func(t, aux);
+	}
+}
+
 /* Idle thread.  Executes when no other thread is ready to run.
 
    The idle thread is initially put on the ready list by
@@ -486,6 +500,15 @@ static void idle(void *idle_started_ UNUSED)
 		intr_disable();
 		thread_block();
 
+		/* Nothing else is runnable: spend the time clearing free
+		   pages so that PAL_ZERO allocations need no memset.  If
+		   some were cleared, go around again without halting, in
+		   case a thread became ready meanwhile. */
+		intr_enable();
+		if (palloc_prezero())
+			continue;
+		intr_disable();
+
 		/* Re-enable interrupts and wait for the next one.
 
 		   The `sti' instruction disables interrupts until the
@@ -786,6 +809,7 @@ static void mlfqs_update_load_avg(void)
 	fixed_t term2 = FP_MUL_MIXED(FP_DIV_MIXED(FP_CONST(1), 60), ready_threads);
 	load_avg = FP_ADD(term1, term2);
 }
+
 static void mlfqs_update_recent_cpu_all(void)
 {
 	struct list_elem *e;
@@ -9,8 +9,16 @@
 /* Number of page faults processed. */
 static long long page_fault_cnt;
 
+/* Number of kernel accesses to user memory resumed at their fixup
+   address because the page could not be faulted in. */
+static long long fixup_cnt;
+
+/* Exception table, collected by the linker script. */
+extern const struct exception_table_entry _start_ex_table[], _end_ex_table[];
+
 static void kill(struct intr_frame *);
 static void page_fault(struct intr_frame *);
+static bool fixup_exception(struct intr_frame *);
 
 /* Registers handlers for interrupts that can be caused by user
 	 programs.
@@ -60,7 +68,8 @@ void exception_init(void)
 /* Prints exception statistics. */
 void exception_print_stats(void)
 {
-	printf("Exception: %lld page faults\n", page_fault_cnt);
+	printf("Exception: %lld page faults, %lld user accesses fixed up\n", page_fault_cnt,
+		   fixup_cnt);
 }
 
 /* Handler for an exception (probably) caused by a user process. */
@@ -142,11 +151,10 @@ static void page_fault(struct intr_frame *f)
 		return;
 #endif
 
-	if (!user) {
-		f->rip = f->R.rax;
-		f->R.rax = -1;
+	/* A kernel access to user memory that could not be paged in
+		 resumes at its fixup address, which reports the failure. */
+	if (!user && fixup_exception(f))
 		return;
-	}
 
 	/* Count page faults. */
 	page_fault_cnt++;
@@ -157,3 +165,19 @@ static void page_fault(struct intr_frame *f)
 		   user ? "user" : "kernel");
 	kill(f);
 }
+
+/* If the kernel instruction that faulted in F has an entry in the
+	 exception table, points F at its fixup address and returns
+	 true.  Otherwise returns false. */
+static bool fixup_exception(struct intr_frame *f)
+{
+	const struct exception_table_entry *e;
+
+	for (e = _start_ex_table; e < _end_ex_table; e++)
+		if (e->insn == f->rip) {
+			f->rip = e->fixup;
+			fixup_cnt++;
+			return true;
+		}
+	return false;
+}
@@ -21,7 +21,6 @@
 #include "threads/vaddr.h"
 #include "userprog/fd_util.h"
 #include "userprog/gdt.h"
-#include "userprog/syscall.h"
 #include "userprog/tss.h"
 #ifdef VM
 #include "vm/vm.h"
@@ -283,6 +282,10 @@ void process_exit(void)
 
 	if (curr->pml4 != NULL)
 		printf("%s: exit(%d)\n", curr->name, curr->my_entry->exit_status);
+#ifdef VM
+	if (curr->pml4 != NULL && vm_ws_report)
+		vm_print_ws(curr);
+#endif
 
 	fd_clean(curr);
 	process_cleanup();
@@ -294,18 +297,17 @@ static void process_cleanup(void)
 {
 	struct thread *curr = thread_current();
 
+#ifdef VM
+	/* 실행 파일 세그먼트 페이지가 파일을 참조하므로 파일을 닫기 전에 정리한다. */
+	supplemental_page_table_kill(&curr->spt);
+#endif
+
 	if (curr->current_file) {
 		file_allow_write(curr->current_file);
-		lock_acquire(&file_lock);
 		file_close(curr->current_file);
-		lock_release(&file_lock);
 		curr->current_file = NULL;
 	}
 
-#ifdef VM
-	supplemental_page_table_kill(&curr->spt);
-#endif
-
 	uint64_t *pml4;
 	/* Destroy the current process's page directory and switch back
 	 * to the kernel-only page directory. */
@@ -415,9 +417,7 @@ static bool load(const char *file_name, int argc, char **argv, struct intr_frame
 	supplemental_page_table_init(&thread_current()->spt);
 
 	/* Open executable file. */
-	lock_acquire(&file_lock);
 	file = filesys_open(file_name);
-	lock_release(&file_lock);
 	if (file == NULL) {
 		printf("load: %s: open failed\n", file_name);
 		goto done;
@@ -486,6 +486,11 @@ static bool load(const char *file_name, int argc, char **argv, struct intr_frame
 		}
 	}
 
+#ifdef VM
+	/* 힙은 마지막 세그먼트 바로 뒤에서 빈 상태로 시작한다. */
+	vma_heap_init(&t->spt);
+#endif
+
 	/* Set up stack. */
 	if (!setup_stack(if_))
 		goto done;
@@ -686,16 +691,14 @@ static bool lazy_load_segment(struct page *page, void *aux)
 	off_t ofs = vm_load_aux->offset;
 	size_t page_read_bytes = vm_load_aux->page_read_bytes;
 
-	lock_acquire(&file_lock);
 	int read_result = file_read_at(file, page->frame->kva, page_read_bytes, ofs);
-	lock_release(&file_lock);
-	if (read_result != (int)page_read_bytes) {
-		palloc_free_page(page->frame->kva);
+	free(aux);
+	// 실패해도 프레임은 프레임 테이블에 붙어 있으므로 여기서 놓지 않는다.
+	// 페이지가 제거될 때 vm_free_frame()이 반납한다
+	if (read_result != (int)page_read_bytes)
 		return false;
-	}
 
 	memset(page->frame->kva + page_read_bytes, 0, PGSIZE - page_read_bytes);
-	free(aux);
 
 	return true;
 }
@@ -707,28 +710,24 @@ static bool load_segment(struct file *file, off_t ofs, uint8_t *upage, uint32_t
 	ASSERT(pg_ofs(upage) == 0);
 	ASSERT(ofs % PGSIZE == 0);
 
-	while (read_bytes > 0 || zero_bytes > 0) {
-		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-		size_t page_zero_bytes = PGSIZE - page_read_bytes;
-
-		struct vm_load_aux *file_page_aux = malloc(sizeof(*file_page_aux));
-		*file_page_aux = (struct vm_load_aux){
-			.offset = ofs,
-			.page_read_bytes = page_read_bytes,
-		};
-		
-		// 파일은 mmap, stack은 anon, 실행파일도 anon!!! write back 기준으로!
-		if (!vm_alloc_page_with_initializer(VM_ANON | VM_LOAD_MARKER, upage, writable, lazy_load_segment,
-											file_page_aux))
-			return false;
-			
-		/* Advance. */
-		read_bytes -= page_read_bytes;
-		zero_bytes -= page_zero_bytes;
-		ofs += page_read_bytes;
-		upage += PGSIZE;
-	}
-	return true;
+	// 읽기 전용 세그먼트는 같은 실행 파일을 쓰는 프로세스끼리 프레임을 공유한다
+	if (!writable)
+		return vm_map_text_segment(upage, file, ofs, read_bytes, zero_bytes);
+
+	// 세그먼트 전체를 하나의 영역으로 등록하고, 페이지는 처음 접근할 때 만든다
+	// 파일은 mmap, stack은 anon, 실행파일도 anon!!! write back 기준으로!
+	struct vma tmpl = {
+		.start = upage,
+		.end = upage + read_bytes + zero_bytes,
+		.type = VM_ANON | VM_LOAD_MARKER,
+		.writable = writable,
+		.init = lazy_load_segment,
+		.file = file,
+		.offset = ofs,
+		.read_bytes = read_bytes,
+		.fault_around = VM_FAULT_AROUND_DEFAULT,
+	};
+	return vma_insert(&thread_current()->spt, &tmpl) != NULL;
 }
 
 /* Create a PAGE of stack at the USER_STACK. Return true on success. */
@@ -5,6 +5,7 @@
 
 #include "filesys/file.h"
 #include "filesys/filesys.h"
+#include "filesys/inode.h"
 #include "intrinsic.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
@@ -36,7 +37,12 @@ void syscall_handler(struct intr_frame *);
 
 #define MAX_FILE_NAME_LEN 16
 
-struct lock file_lock;
+/* read_to_user()와 write_from_user()가 한 번에 pin하고 inode 락 한 번으로 처리하는 최대 페이지 수.
+ * 이보다 큰 요청은 이 단위로 나뉘므로 묶음 사이에서는 다른 읽기나 쓰기가 끼어들 수 있다. */
+#define USER_IO_PAGES 16
+
+/* Only one thread at a time may wait for keyboard input. */
+static struct lock stdin_lock;
 
 static void syscall_halt(void);
 static void syscall_exit(int status);
@@ -55,6 +61,25 @@ static void syscall_close(int fd);
 static int syscall_dup2(int oldfd, int newfd);
 static void *syscall_mmap(void *addr, size_t length, int writable, int fd, off_t offset);
 static void syscall_munmap(void *addr);
+static int syscall_msync(void *addr, size_t length, int flags);
+static int syscall_madvise(void *addr, size_t length, int advice);
+static void *syscall_sbrk(intptr_t increment);
+#ifndef NDEBUG
+static void syscall_memstat(struct memstat *stat);
+#endif
+static int syscall_pread(int fd, void *buffer, unsigned size, off_t offset);
+static int syscall_pwrite(int fd, const void *buffer, unsigned size, off_t offset);
+static int syscall_readv(int fd, const struct iovec *iov, int iovcnt);
+static int syscall_writev(int fd, const struct iovec *iov, int iovcnt);
+
+static unsigned read_to_user(struct file *file, void *buffer, unsigned size, off_t offset);
+static unsigned write_from_user(struct file *file, const void *buffer, unsigned size,
+								off_t offset);
+static size_t pin_user_io(struct user_chunk chunks[], struct inode_iovec iov[], char *buffer,
+						  unsigned size, bool write, unsigned *len);
+static void unpin_user_io(struct user_chunk chunks[], size_t cnt);
+static int write_console(const struct iovec *iov, int iovcnt, unsigned size);
+static struct iovec *copy_iovec(const struct iovec *iov, int iovcnt, bool write, unsigned *size);
 
 void syscall_init(void)
 {
@@ -65,7 +90,7 @@ void syscall_init(void)
 	 * until the syscall_entry swaps the userland stack to the kernel
 	 * mode stack. Therefore, we masked the FLAG_FL. */
 	write_msr(MSR_SYSCALL_MASK, FLAG_IF | FLAG_TF | FLAG_DF | FLAG_IOPL | FLAG_AC | FLAG_NT);
-	lock_init(&file_lock);
+	lock_init(&stdin_lock);
 }
 
 /* The main system call interface */
@@ -131,6 +156,32 @@ void syscall_handler(struct intr_frame *f)
 		case SYS_MUNMAP:
 			syscall_munmap(arg1);
 			break;
+		case SYS_MSYNC:
+			f->R.rax = syscall_msync((void *)arg1, arg2, arg3);
+			break;
+		case SYS_MADVISE:
+			f->R.rax = syscall_madvise((void *)arg1, arg2, arg3);
+			break;
+#ifndef NDEBUG
+		case SYS_MEMSTAT:
+			syscall_memstat((struct memstat *)arg1);
+			break;
+#endif
+		case SYS_SBRK:
+			f->R.rax = (uint64_t)syscall_sbrk(arg1);
+			break;
+		case SYS_PREAD:
+			f->R.rax = syscall_pread(arg1, (void *)arg2, arg3, arg4);
+			break;
+		case SYS_PWRITE:
+			f->R.rax = syscall_pwrite(arg1, (const void *)arg2, arg3, arg4);
+			break;
+		case SYS_READV:
+			f->R.rax = syscall_readv(arg1, (const struct iovec *)arg2, arg3);
+			break;
+		case SYS_WRITEV:
+			f->R.rax = syscall_writev(arg1, (const struct iovec *)arg2, arg3);
+			break;
 	}
 }
 
@@ -177,9 +228,7 @@ static bool syscall_create(const char *file, unsigned initial_size)
 	if (!copy_user_string(kernel_file_name, file, MAX_FILE_NAME_LEN))
 		return false;
 
-	lock_acquire(&file_lock);
 	bool success = filesys_create(kernel_file_name, initial_size);
-	lock_release(&file_lock);
 
 	return success;
 }
@@ -191,9 +240,7 @@ static bool syscall_remove(const char *file)
 	if (!copy_user_string(kernel_file_name, file, MAX_FILE_NAME_LEN))
 		return false;
 
-	lock_acquire(&file_lock);
 	bool success = filesys_remove(kernel_file_name);
-	lock_release(&file_lock);
 
 	return success;
 }
@@ -205,9 +252,7 @@ static int syscall_open(const char *file)
 	if (!copy_user_string(kernel_file_name, file, MAX_FILE_NAME_LEN))
 		return -1;
 
-	lock_acquire(&file_lock);
 	struct file *open_file = filesys_open(kernel_file_name);
-	lock_release(&file_lock);
 
 	if (open_file == NULL)
 		return -1;
@@ -226,9 +271,7 @@ static int syscall_filesize(int fd)
 	if (file == NULL || file == stdin_entry || file == stdout_entry)
 		return -1;
 
-	lock_acquire(&file_lock);
 	result = file_length(file);
-	lock_release(&file_lock);
 
 	return result;
 }
@@ -238,29 +281,15 @@ static int syscall_read(int fd, void *buffer, unsigned size)
 	if (size == 0)
 		return 0;
 
-	int result;
-	char *kernel_buffer = malloc(size);
-
 	struct file *file = get_file(thread_current()->fd_table, fd);
-	if (file == NULL || file == stdout_entry) {
-		free(kernel_buffer);
+	if (file == NULL || file == stdout_entry)
 		return -1;
-	}
-
-	lock_acquire(&file_lock);
-	if (file == stdin_entry) {
-		for (int i = 0; i < size; i++)
-			kernel_buffer[i] = input_getc();
-		result = size;
-	} else {
-		result = file_read(file, kernel_buffer, size);
-	}
-	lock_release(&file_lock);
-
-	if (!buffer_copy_to_user(buffer, kernel_buffer, result))
-		syscall_exit(-1);
+	if (file == stdin_entry)
+		return read_to_user(file, buffer, size, 0);
 
-	free(kernel_buffer);
+	off_t pos = file_tell(file);
+	unsigned result = read_to_user(file, buffer, size, pos);
+	file_seek(file, pos + result);
 	return result;
 }
 
@@ -269,30 +298,18 @@ static int syscall_write(int fd, const void *buffer, unsigned size)
 	if (size == 0)
 		return 0;
 
-	int result;
-	char *kernel_buffer = malloc(size);
-	if (!copy_user_buffer(kernel_buffer, buffer, size)) {
-		free(kernel_buffer);
-		return -1;
-	}
-
 	struct file *file = get_file(thread_current()->fd_table, fd);
-
-	if (file == NULL || file == stdin_entry) {
-		free(kernel_buffer);
+	if (file == NULL || file == stdin_entry)
 		return -1;
-	}
 
-	lock_acquire(&file_lock);
 	if (file == stdout_entry) {
-		putbuf(kernel_buffer, size);
-		result = size;
-	} else {
-		result = file_write(file, kernel_buffer, size);
+		struct iovec iov = {(void *)buffer, size};
+		return write_console(&iov, 1, size);
 	}
-	lock_release(&file_lock);
 
-	free(kernel_buffer);
+	off_t pos = file_tell(file);
+	unsigned result = write_from_user(file, buffer, size, pos);
+	file_seek(file, pos + result);
 	return result;
 }
 
@@ -303,9 +320,7 @@ static void syscall_seek(int fd, unsigned position)
 	if (file == NULL)
 		return;
 
-	lock_acquire(&file_lock);
 	file_seek(file, position);
-	lock_release(&file_lock);
 }
 
 static unsigned syscall_tell(int fd)
@@ -314,24 +329,18 @@ static unsigned syscall_tell(int fd)
 	if (!file)
 		return 0;
 
-	lock_acquire(&file_lock);
 	unsigned result = file_tell(file);
-	lock_release(&file_lock);
 	return result;
 }
 
 static void syscall_close(int fd)
 {
-	lock_acquire(&file_lock);
 	fd_close(thread_current()->fd_table, fd);
-	lock_release(&file_lock);
 }
 
 static int syscall_dup2(int oldfd, int newfd)
 {
-	lock_acquire(&file_lock);
 	int result = fd_dup2(thread_current()->fd_table, oldfd, newfd);
-	lock_release(&file_lock);
 	return result;
 }
 
@@ -341,20 +350,18 @@ static void *syscall_mmap(void *addr, size_t length, int writable, int fd, off_t
 		pg_ofs(offset) != 0)
 		return NULL;
 
-	size_t read_bytes = length;
-	void *start_addr = addr;
-
-	while (read_bytes > 0) {
-		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-		if (!is_user_vaddr(start_addr) || spt_find_page(&thread_current()->spt, start_addr) != NULL)
-			return NULL;
-
-		if (start_addr <= USER_STACK && start_addr >= USER_STACK - (1 << 20))
-			return NULL;
+	// 영역 전체가 유저 영역 안에 있고 스택 영역이나 다른 영역과 겹치지 않아야 한다
+	void *end = pg_round_up(addr + length);
+	if (end <= addr || !is_user_vaddr(end - 1))
+		return NULL;
+	if (addr <= USER_STACK && end > USER_STACK - (1 << 20))
+		return NULL;
+	if (vma_overlaps(&thread_current()->spt, addr, end))
+		return NULL;
 
-		start_addr += PGSIZE;
-		read_bytes -= page_read_bytes;
-	}
+	// 파일 없는 매핑은 0으로 채워진 anon 영역이 된다
+	if (fd == MAP_ANONYMOUS)
+		return offset == 0 ? do_mmap_anon(addr, length, writable) : NULL;
 
 	struct file *file = get_file(thread_current()->fd_table, fd);
 	if (file == NULL || file == stdout_entry || file == stdin_entry || file_length(file) == 0)
@@ -369,4 +376,286 @@ static void syscall_munmap(void *addr)
 		return;
 
 	return do_munmap(addr);
-}
\ No newline at end of file
+}
+
+static int syscall_msync(void *addr, size_t length, int flags)
+{
+	if (addr == NULL || is_kernel_vaddr(addr) || pg_ofs(addr) != 0 || addr + length < addr
+		|| !is_user_vaddr(addr + length - 1))
+		return -1;
+	if (flags != MS_ASYNC && flags != MS_SYNC)
+		return -1;
+
+	return do_msync(addr, length, flags == MS_SYNC) ? 0 : -1;
+}
+
+static int syscall_madvise(void *addr, size_t length, int advice)
+{
+	if (addr == NULL || is_kernel_vaddr(addr) || pg_ofs(addr) != 0 || addr + length < addr
+		|| !is_user_vaddr(addr + length - 1))
+		return -1;
+	if (advice < MADV_NORMAL || advice > MADV_DONTNEED)
+		return -1;
+
+	return vm_madvise(addr, length, advice) ? 0 : -1;
+}
+
+static void *syscall_sbrk(intptr_t increment)
+{
+	return vma_sbrk(&thread_current()->spt, increment);
+}
+
+#ifndef NDEBUG
+/* 테스트용 훅: 현재 프로세스의 메모리 사용량을 STAT에 담는다.
+ * madvise 테스트가 결과를 확인하는 데만 쓰므로 NDEBUG 빌드에는 넣지 않는다. */
+static void syscall_memstat(struct memstat *stat)
+{
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	struct memstat kernel_stat = {
+		.rss = spt->rss,
+		.wss = spt->wss,
+		.faults = spt->fault_total,
+		.fault_rate = spt->fault_rate,
+	};
+
+	if (!buffer_copy_to_user((char *)stat, (const char *)&kernel_stat, sizeof kernel_stat))
+		syscall_exit(-1);
+}
+#endif
+
+/* 파일의 위치를 쓰지도 옮기지도 않고 OFFSET부터 읽는다. */
+static int syscall_pread(int fd, void *buffer, unsigned size, off_t offset)
+{
+	struct file *file = get_file(thread_current()->fd_table, fd);
+	if (file == NULL || file == stdin_entry || file == stdout_entry)
+		return -1;
+	if (offset < 0 || size > (unsigned)(INT32_MAX - offset))
+		return -1;
+
+	return read_to_user(file, buffer, size, offset);
+}
+
+/* 파일의 위치를 쓰지도 옮기지도 않고 OFFSET부터 쓴다. */
+static int syscall_pwrite(int fd, const void *buffer, unsigned size, off_t offset)
+{
+	struct file *file = get_file(thread_current()->fd_table, fd);
+	if (file == NULL || file == stdin_entry || file == stdout_entry)
+		return -1;
+	if (offset < 0 || size > (unsigned)(INT32_MAX - offset))
+		return -1;
+
+	return write_from_user(file, buffer, size, offset);
+}
+
+/* 파일의 현재 위치부터 IOV의 버퍼들을 차례로 채운다.
+ * 버퍼 하나를 다 채우지 못하면 (파일 끝) 거기서 멈춘다. 위치는 마지막에 한 번만 옮긴다. */
+static int syscall_readv(int fd, const struct iovec *iov, int iovcnt)
+{
+	struct file *file = get_file(thread_current()->fd_table, fd);
+	if (file == NULL || file == stdout_entry)
+		return -1;
+	if (iovcnt == 0)
+		return 0;
+
+	unsigned size;
+	struct iovec *kernel_iov = copy_iovec(iov, iovcnt, true, &size);
+	if (kernel_iov == NULL)
+		return -1;
+
+	off_t pos = file == stdin_entry ? 0 : file_tell(file);
+	unsigned result = 0;
+	for (int i = 0; i < iovcnt; i++) {
+		unsigned read = read_to_user(file, kernel_iov[i].iov_base, kernel_iov[i].iov_len,
+									 pos + result);
+		result += read;
+		if (read < kernel_iov[i].iov_len)
+			break;
+	}
+	if (file != stdin_entry)
+		file_seek(file, pos + result);
+
+	free(kernel_iov);
+	return result;
+}
+
+/* IOV의 버퍼들을 차례로 파일의 현재 위치부터 이어서 쓴다.
+ * 버퍼 하나를 다 쓰지 못하면 거기서 멈춘다. 위치는 마지막에 한 번만 옮긴다. */
+static int syscall_writev(int fd, const struct iovec *iov, int iovcnt)
+{
+	struct file *file = get_file(thread_current()->fd_table, fd);
+	if (file == NULL || file == stdin_entry)
+		return -1;
+	if (iovcnt == 0)
+		return 0;
+
+	unsigned size;
+	struct iovec *kernel_iov = copy_iovec(iov, iovcnt, false, &size);
+	if (kernel_iov == NULL)
+		return -1;
+
+	int result;
+	if (file == stdout_entry) {
+		result = write_console(kernel_iov, iovcnt, size);
+	} else {
+		off_t pos = file_tell(file);
+		unsigned written = 0;
+		for (int i = 0; i < iovcnt; i++) {
+			unsigned n = write_from_user(file, kernel_iov[i].iov_base, kernel_iov[i].iov_len,
+										 pos + written);
+			written += n;
+			if (n < kernel_iov[i].iov_len)
+				break;
+		}
+		file_seek(file, pos + written);
+		result = written;
+	}
+
+	free(kernel_iov);
+	return result;
+}
+
+/* 유저 버퍼 BUFFER의 SIZE 바이트 중 앞쪽 최대 USER_IO_PAGES 페이지를 pin해서 CHUNKS에 넣고,
+ * 각 조각의 kva를 IOV에 채운다. 조각 수를 반환하고 그 길이의 합을 *LEN에 넣는다.
+ * pin하지 못하면 이미 pin한 조각을 풀고 프로세스를 종료한다. */
+static size_t pin_user_io(struct user_chunk chunks[], struct inode_iovec iov[], char *buffer,
+						  unsigned size, bool write, unsigned *len)
+{
+	size_t cnt = 0;
+	*len = 0;
+	while (cnt < USER_IO_PAGES && *len < size) {
+		if (!pin_user_chunk(&chunks[cnt], buffer + *len, size - *len, write)) {
+			unpin_user_io(chunks, cnt);
+			thread_exit();
+		}
+		iov[cnt] = (struct inode_iovec){.buf = chunks[cnt].kva, .size = chunks[cnt].len};
+		*len += chunks[cnt].len;
+		cnt++;
+	}
+	return cnt;
+}
+
+/* pin_user_io()가 pin한 CHUNKS[0..CNT)를 푼다. */
+static void unpin_user_io(struct user_chunk chunks[], size_t cnt)
+{
+	for (size_t i = 0; i < cnt; i++)
+		unpin_user_chunk(&chunks[i]);
+}
+
+/* 유저 버퍼 BUFFER를 USER_IO_PAGES 페이지씩 pin해서 FILE의 OFFSET부터 그 프레임들에 바로 읽어 들인다.
+ * 한 묶음은 inode 락을 한 번 잡고 읽으므로 그 사이에 끝난 쓰기의 일부만 보는 일이 없다.
+ * FILE이 stdin이면 OFFSET은 무시하고 키보드에서 읽는다. 읽은 바이트 수를 반환한다.
+ * 버퍼가 잘못되었으면 아무것도 읽기 전에 프로세스를 종료한다. */
+static unsigned read_to_user(struct file *file, void *buffer, unsigned size, off_t offset)
+{
+	if (!check_user_range(buffer, size, true))
+		thread_exit();
+
+	unsigned result = 0;
+	while (result < size) {
+		struct user_chunk chunks[USER_IO_PAGES];
+		struct inode_iovec iov[USER_IO_PAGES];
+		unsigned len;
+		size_t cnt = pin_user_io(chunks, iov, (char *)buffer + result, size - result, true, &len);
+
+		unsigned read;
+		if (file == stdin_entry) {
+			lock_acquire(&stdin_lock);
+			for (size_t i = 0; i < cnt; i++)
+				for (off_t j = 0; j < iov[i].size; j++)
+					((char *)iov[i].buf)[j] = input_getc();
+			lock_release(&stdin_lock);
+			read = len;
+		} else {
+			read = file_readv_at(file, iov, cnt, offset + result);
+		}
+		unpin_user_io(chunks, cnt);
+
+		result += read;
+		if (read < len)
+			break;
+	}
+	return result;
+}
+
+/* 유저 버퍼 BUFFER를 USER_IO_PAGES 페이지씩 pin해서 그 프레임들에서 FILE의 OFFSET부터 바로 쓴다.
+ * 한 묶음은 inode 락을 한 번 잡고 쓰므로 다른 읽기는 그 묶음을 전부 보거나 전혀 보지 않는다.
+ * 쓴 바이트 수를 반환한다. 버퍼가 잘못되었으면 아무것도 쓰기 전에 프로세스를 종료한다. */
+static unsigned write_from_user(struct file *file, const void *buffer, unsigned size,
+								off_t offset)
+{
+	if (!check_user_range(buffer, size, false))
+		thread_exit();
+
+	unsigned result = 0;
+	while (result < size) {
+		struct user_chunk chunks[USER_IO_PAGES];
+		struct inode_iovec iov[USER_IO_PAGES];
+		unsigned len;
+		size_t cnt = pin_user_io(chunks, iov, (char *)buffer + result, size - result, false, &len);
+
+		unsigned written = file_writev_at(file, iov, cnt, offset + result);
+		unpin_user_io(chunks, cnt);
+
+		result += written;
+		if (written < len)
+			break;
+	}
+	return result;
+}
+
+/* IOV의 버퍼들(모두 합쳐 SIZE 바이트)을 콘솔에 출력한다.
+ * 다른 프로세스의 출력과 섞이지 않도록 한데 모아 한 번의 putbuf()로 내보낸다.
+ * 버퍼들은 copy_iovec()이 이미 검사했으므로, 복사하다 프로세스가 종료되어
+ * KERNEL_BUFFER를 잃는 일은 없다. */
+static int write_console(const struct iovec *iov, int iovcnt, unsigned size)
+{
+	if (size == 0)
+		return 0;
+
+	char *kernel_buffer = malloc(size);
+	if (kernel_buffer == NULL)
+		return -1;
+
+	unsigned ofs = 0;
+	for (int i = 0; i < iovcnt; i++) {
+		if (iov[i].iov_len == 0)
+			continue;
+		copy_user_buffer(kernel_buffer + ofs, iov[i].iov_base, iov[i].iov_len);
+		ofs += iov[i].iov_len;
+	}
+	putbuf(kernel_buffer, size);
+	free(kernel_buffer);
+	return size;
+}
+
+/* 유저의 iovec 배열 IOV[0..IOVCNT)를 커널로 복사해 반환하고, 버퍼 크기의 합을 *SIZE에 넣는다.
+ * IOVCNT가 범위를 벗어나거나 합이 int로 나타낼 수 없을 만큼 크거나 메모리가 부족하면 NULL.
+ * 배열이나 버퍼 중 하나라도 읽을 수 없거나 WRITE인데 쓸 수 없으면, 할당한 배열을 해제하고
+ * 프로세스를 종료한다. 그래서 호출자는 이후 버퍼를 복사하다 종료되어 메모리를 잃지 않는다.
+ * 반환된 배열은 호출자가 free()한다. */
+static struct iovec *copy_iovec(const struct iovec *iov, int iovcnt, bool write, unsigned *size)
+{
+	if (iovcnt < 0 || iovcnt > IOV_MAX)
+		return NULL;
+	if (!check_user_range(iov, iovcnt * sizeof *iov, false))
+		thread_exit();
+
+	struct iovec *kernel_iov = malloc(iovcnt * sizeof *kernel_iov);
+	if (kernel_iov == NULL)
+		return NULL;
+	copy_user_buffer((char *)kernel_iov, (const char *)iov, iovcnt * sizeof *kernel_iov);
+
+	*size = 0;
+	for (int i = 0; i < iovcnt; i++) {
+		if (!check_user_range(kernel_iov[i].iov_base, kernel_iov[i].iov_len, write)) {
+			free(kernel_iov);
+			thread_exit();
+		}
+		if (kernel_iov[i].iov_len > (size_t)(INT32_MAX - *size)) {
+			free(kernel_iov);
+			return NULL;
+		}
+		*size += kernel_iov[i].iov_len;
+	}
+	return kernel_iov;
+}
@@ -1,32 +1,66 @@
 #include "userprog/validate.h"
 
+#include <stdio.h>
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#include "userprog/exception.h"
+
+struct frame;
+
+/* Statistics for user_copy_print_stats().  Each chunk lies in one
+ * page, so CHUNK_CNT is roughly the number of user pages looked up,
+ * where the old byte-at-a-time copies did one lookup per byte. */
+static long long copy_byte_cnt;	 /* Bytes copied to or from user memory. */
+static long long copy_chunk_cnt; /* Page-sized pieces they were copied in. */
 
 static int64_t get_user(const uint8_t *uaddr);
 static bool put_user(uint8_t *udst, uint8_t byte);
+static size_t copy_bytes(void *dst, const void *src, size_t size);
+static size_t chunk_length(const void *uaddr, size_t len);
+static struct frame *pin_user_page(const void *uaddr, bool write);
+static void unpin_user_page(struct frame *frame);
 
+/* Copies MAX_LEN bytes from USER_SRC into KERNEL_DST a page at a time.
+ * Each page is faulted in by its first byte and then pinned, so that it
+ * is not evicted while the rest of the page is copied in one go. */
 bool copy_user_buffer(char *kernel_dst, const char *user_src, size_t max_len)
 {
-	if (kernel_dst == NULL || user_src == NULL || !is_user_vaddr(user_src))
+	if (kernel_dst == NULL || user_src == NULL)
 		thread_exit();
 
-	for (size_t i = 0; i < max_len; i++) {
-		int64_t user_char = get_user(user_src + i);
+	size_t i = 0;
+	while (i < max_len) {
+		const char *chunk = user_src + i;
+		size_t len = chunk_length(chunk, max_len - i);
+		if (!is_user_vaddr(chunk))
+			thread_exit();
+
+		int64_t user_char = get_user((const uint8_t *)chunk);
 		if (user_char == -1)
 			thread_exit();
 		kernel_dst[i] = (char)user_char;
+
+		struct frame *frame = pin_user_page(chunk, false);
+		size_t left = copy_bytes(kernel_dst + i + 1, chunk + 1, len - 1);
+		unpin_user_page(frame);
+		if (left != 0)
+			thread_exit();
+		copy_chunk_cnt++;
+		copy_byte_cnt += len;
+		i += len;
 	}
 	return true;
 }
 
 bool copy_user_string(char *kernel_dst, const char *user_src, size_t max_len)
 {
-	if (kernel_dst == NULL || user_src == NULL || !is_user_vaddr(user_src))
+	if (kernel_dst == NULL || user_src == NULL)
 		thread_exit();
 
 	for (size_t i = 0; i < max_len; i++) {
-		int64_t user_char = get_user(user_src + i);
+		if (!is_user_vaddr(user_src + i))
+			thread_exit();
+		int64_t user_char = get_user((const uint8_t *)user_src + i);
 		if (user_char == -1)
 			thread_exit();
 		kernel_dst[i] = (char)user_char;
@@ -36,29 +70,154 @@ bool copy_user_string(char *kernel_dst, const char *user_src, size_t max_len)
 	return false;
 }
 
+/* Copies MAX_LEN bytes from KERNEL_SRC to USER_DST a page at a time,
+ * pinning each destination page the same way as copy_user_buffer().
+ * Each page is looked up in the supplemental page table only once. */
 bool buffer_copy_to_user(char *user_dst, const char *kernel_src, size_t max_len)
 {
-	if (user_dst == NULL || kernel_src == NULL || !is_user_vaddr(user_dst))
+	if (user_dst == NULL || kernel_src == NULL)
 		thread_exit();
-	for (size_t i = 0; i < max_len; i++) {
-		if (!put_user(user_dst + i, kernel_src[i]) ||
-			!spt_find_page(&thread_current()->spt, user_dst)->writable)
+
+	size_t i = 0;
+	while (i < max_len) {
+		char *chunk = user_dst + i;
+		size_t len = chunk_length(chunk, max_len - i);
+		if (!is_user_vaddr(chunk))
+			thread_exit();
+
+		if (!put_user((uint8_t *)chunk, kernel_src[i]) ||
+			!spt_find_page(&thread_current()->spt, chunk)->writable)
 			thread_exit();
+
+		struct frame *frame = pin_user_page(chunk, true);
+		size_t left = copy_bytes(chunk + 1, kernel_src + i + 1, len - 1);
+		unpin_user_page(frame);
+		if (left != 0)
+			thread_exit();
+		copy_chunk_cnt++;
+		copy_byte_cnt += len;
+		i += len;
 	}
 	return true;
 }
 
+/* Returns true if every byte of the SIZE-byte user buffer at UADDR
+ * can be read or, for WRITE, written, false otherwise.  Touches one
+ * byte in each page, which faults the pages in but does not pin them.
+ * Lets a system call reject a bad buffer before it allocates memory
+ * or moves any data. */
+bool check_user_range(const void *uaddr, size_t size, bool write)
+{
+	const uint8_t *start = uaddr;
+	if (size == 0)
+		return true;
+	if (start == NULL || !is_user_vaddr(start) || start + size - 1 < start
+		|| !is_user_vaddr(start + size - 1))
+		return false;
+
+	for (const uint8_t *page = pg_round_down(start); page <= start + size - 1; page += PGSIZE) {
+		uint8_t *byte = (uint8_t *)(page < start ? start : page);
+		int64_t user_char = get_user(byte);
+		if (user_char == -1)
+			return false;
+		if (write && (!put_user(byte, user_char)
+					  || !spt_find_page(&thread_current()->spt, byte)->writable))
+			return false;
+	}
+	return true;
+}
+
+/* Faults in and pins the user page that contains UADDR, and fills in
+ * CHUNK with the part of the SIZE-byte buffer at UADDR that lies in
+ * that page.  WRITE says whether the kernel will write to the chunk.
+ * Until unpin_user_chunk(), the chunk can be read or written through
+ * CHUNK->kva without page faults, so it is safe to do so while holding
+ * an inode's rwlock in file_read() or file_write().  Returns false,
+ * with nothing pinned, if UADDR is not a valid user address or, for
+ * WRITE, is not writable; the caller releases its other chunks and
+ * terminates the process. */
+bool pin_user_chunk(struct user_chunk *chunk, void *uaddr, size_t size, bool write)
+{
+	if (uaddr == NULL || !is_user_vaddr(uaddr))
+		return false;
+
+	int64_t user_char = get_user(uaddr);
+	if (user_char == -1 || (write && !put_user(uaddr, user_char)))
+		return false;
+
+	chunk->len = chunk_length(uaddr, size);
+#ifdef VM
+	chunk->frame = vm_pin_user(uaddr, write);
+	if (chunk->frame == NULL)
+		return false;
+	chunk->kva = chunk->frame->kva + pg_ofs(uaddr);
+#else
+	chunk->frame = NULL;
+	chunk->kva = uaddr;
+#endif
+	copy_chunk_cnt++;
+	copy_byte_cnt += chunk->len;
+	return true;
+}
+
+/* Releases CHUNK, pinned by pin_user_chunk(). */
+void unpin_user_chunk(struct user_chunk *chunk)
+{
+	unpin_user_page(chunk->frame);
+}
+
+/* Prints user copy statistics. */
+void user_copy_print_stats(void)
+{
+	printf("User copy: %lld bytes in %lld page chunks\n", copy_byte_cnt, copy_chunk_cnt);
+}
+
+/* Returns how many of the LEN bytes starting at UADDR lie in
+ * UADDR's page. */
+static size_t chunk_length(const void *uaddr, size_t len)
+{
+	size_t left = PGSIZE - pg_ofs(uaddr);
+	return len < left ? len : left;
+}
+
+/* Pins the frame holding the user page that contains UADDR, which
+ * must already have been accessed, and returns it, or returns a null
+ * pointer on failure.  Copies stay correct without a pin, since every
+ * access that faults is caught through the exception table; the pin
+ * only keeps the page from being evicted and faulted in again partway
+ * through. */
+static struct frame *pin_user_page(const void *uaddr, bool write)
+{
+#ifdef VM
+	return vm_pin_user(uaddr, write);
+#else
+	(void)uaddr;
+	(void)write;
+	return NULL;
+#endif
+}
+
+/* Releases a pin taken by pin_user_page(). */
+static void unpin_user_page(struct frame *frame)
+{
+#ifdef VM
+	if (frame != NULL)
+		vm_frame_unpin(frame);
+#else
+	(void)frame;
+#endif
+}
+
 /* Reads a byte at user virtual address UADDR.
  * UADDR must be below KERN_BASE.
  * Returns the byte value if successful, -1 if a segfault
  * occurred. */
 static int64_t get_user(const uint8_t *uaddr)
 {
-	int64_t result;
-	__asm __volatile("movabsq $done_get, %0\n"
-					 "movzbq %1, %0\n"
-					 "done_get:\n"
-					 : "=&a"(result)
+	int64_t result = -1;
+	__asm __volatile("1: movzbq %1, %0\n"
+					 "2:\n" EX_TABLE_ENTRY("1b", "2b")
+					 : "+r"(result)
 					 : "m"(*uaddr));
 	return result;
 }
@@ -68,11 +227,25 @@ static int64_t get_user(const uint8_t *uaddr)
  * Returns true if successful, false if a segfault occurred. */
 static bool put_user(uint8_t *udst, uint8_t byte)
 {
-	int64_t error_code;
-	__asm __volatile("movabsq $done_put, %0\n"
-					 "movb %b2, %1\n"
-					 "done_put:\n"
-					 : "=&a"(error_code), "=m"(*udst)
+	int error = 1;
+	__asm __volatile("1: movb %b2, %1\n"
+					 "movl $0, %0\n"
+					 "2:\n" EX_TABLE_ENTRY("1b", "2b")
+					 : "+r"(error), "=m"(*udst)
 					 : "q"(byte));
-	return error_code != -1;
-}
\ No newline at end of file
+	return error == 0;
+}
+
+/* Copies SIZE bytes from SRC to DST with `rep movsb', either of which
+ * may be a user address below KERN_BASE.  A fault that cannot be paged
+ * in stops the copy where it happened.  Returns the number of bytes
+ * left uncopied, so 0 means success. */
+static size_t copy_bytes(void *dst, const void *src, size_t size)
+{
+	__asm __volatile("1: rep movsb\n"
+					 "2:\n" EX_TABLE_ENTRY("1b", "2b")
+					 : "+D"(dst), "+S"(src), "+c"(size)
+					 :
+					 : "memory");
+	return size;
+}
@@ -1,6 +1,21 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+struct frame;
+
+/* A piece of a user buffer that lies within one page, faulted in
+   and pinned so that the kernel can access it directly through KVA,
+   even while holding locks that the page fault handler needs. */
+struct user_chunk {
+	void *kva;			 /* Kernel address of the piece. */
+	size_t len;			 /* Length of the piece in bytes. */
+	struct frame *frame; /* Pinned frame, or a null pointer. */
+};
+
 bool copy_user_buffer(char *kernel_dst, const char *user_src, size_t max_len);
 bool copy_user_string(char *kernel_dst, const char *user_src, size_t max_len);
-bool buffer_copy_to_user(char *user_dst, const char *kernel_src, size_t max_len);
\ No newline at end of file
+bool buffer_copy_to_user(char *user_dst, const char *kernel_src, size_t max_len);
+bool check_user_range(const void *uaddr, size_t size, bool write);
+bool pin_user_chunk(struct user_chunk *chunk, void *uaddr, size_t size, bool write);
+void unpin_user_chunk(struct user_chunk *chunk);
+void user_copy_print_stats(void);
\ No newline at end of file
@@ -2,8 +2,16 @@
 
 #include "vm/vm.h"
 #include "devices/disk.h"
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
 #include "threads/vaddr.h"
 #include <bitmap.h>
+#include <lz.h>
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
 
 /* DO NOT MODIFY BELOW LINE */
 static struct disk *swap_disk;
@@ -12,6 +20,76 @@ static bool anon_swap_out(struct page *page);
 static void anon_destroy(struct page *page);
 
 static struct bitmap *swap_table;
+/* 슬롯마다 그 슬롯을 가리키는 페이지 수. 공유 중인 프레임을 내보내면 공유자들이 한 슬롯을 함께 쓴다. */
+static uint16_t *swap_refs;
+
+/* 슬롯 하나(= 페이지 하나)가 차지하는 섹터 수 */
+#define SECTORS_PER_SLOT (PGSIZE / DISK_SECTOR_SIZE)
+/* 한 번에 예약하는 연속 슬롯 수. 연달아 쫓겨나는 페이지들이 디스크에 순서대로 놓인다. */
+#define SWAP_CLUSTER 16
+
+static struct lock swap_lock; // swap_table과 아래 커서들을 보호
+static size_t swap_cursor;	  // next-fit 커서: 다음 클러스터를 찾기 시작할 슬롯
+static size_t cluster_next;	  // 현재 클러스터에서 다음에 내줄 슬롯
+static size_t cluster_end;	  // 현재 클러스터의 끝 (미포함)
+static size_t swap_used;	  // 사용 중인 슬롯 수
+
+static size_t swap_slot_alloc(void);
+static size_t swap_cluster_reserve(void);
+static void swap_slot_free(size_t slot);
+static void swap_cache_keep(struct anon_page *anon_page);
+static void swap_read(size_t slot, void *kva);
+
+/* pageout 데몬이 한 번 깨어나 내보내는 anon 페이지 묶음. 빈 클러스터 하나를 통째로 예약해
+ * 쫓겨나는 페이지에 차례로 슬롯을 배정하고 내용은 swap_batch_buf에 복사해 둔 뒤,
+ * 클러스터가 차거나 데몬이 멈출 때 disk_write_multiple 한 번으로 쓴다. 프레임은 복사한 즉시
+ * 반납할 수 있다. 아직 쓰지 않은 슬롯을 읽어 들이는 swap-in은 버퍼에서 복사한다.
+ * 묶음도 예약한 슬롯마다 참조를 하나씩 갖고 있어서, 쓰기 전에 페이지가 사라져도 슬롯이
+ * 다른 페이지에 배정되지 않는다. */
+static struct lock swap_batch_lock;		// 아래 묶음 상태를 보호
+static struct thread *swap_batch_owner; // 묶음을 모으는 스레드. 없으면 NULL
+static uint8_t *swap_batch_buf;			// SWAP_CLUSTER 페이지. i번째 페이지가 슬롯 base + i의 내용
+static size_t swap_batch_base;			// 예약한 클러스터의 첫 슬롯. 없으면 BITMAP_ERROR
+static size_t swap_batch_cnt;			// 앞에서부터 배정한 슬롯 수
+
+static bool swap_batch_add(struct anon_page *anon_page, const void *kva);
+static void swap_batch_write(void);
+
+static long long swap_write_cnt;	 /* swap 디스크에 쓴 페이지 수 */
+static long long swap_write_io_cnt;	 /* 그에 쓰인 disk_write_multiple 호출 수 */
+static long long swap_cache_hit_cnt; /* 스왑 캐시 덕분에 쓰지 않고 내보낸 페이지 수 */
+
+/* 압축 스왑. 쫓겨나는 anon 페이지를 압축해 커널 풀의 아레나에 두고,
+ * 아레나에 자리가 없거나 잘 압축되지 않는 페이지만 swap 디스크에 쓴다. */
+#define ZSWAP_CHUNK 64				   /* 아레나 할당 단위 (바이트) */
+#define ZSWAP_MAX_LEN (PGSIZE * 3 / 4) /* 압축 결과가 이보다 크면 디스크로 보낸다 */
+size_t vm_zswap_pages = 64;			   /* 아레나 크기 (페이지 수). 0이면 쓰지 않는다 */
+
+/* 아레나에 저장된 압축 페이지 하나. 연속된 청크들의 앞에 놓인다. */
+struct zswap_entry {
+	uint16_t len;  /* 압축된 바이트 수 */
+	uint16_t refs; /* 이 항목을 가리키는 페이지 수 */
+	uint8_t data[];
+};
+
+static struct lock zswap_lock;				 // 아래 아레나 상태와 작업 버퍼를 보호
+static uint8_t *zswap_arena;				 // vm_zswap_pages개의 연속된 커널 페이지
+static struct bitmap *zswap_map;			 // 청크별 사용 여부
+static size_t zswap_cursor;					 // next-fit 커서
+static uint16_t zswap_hash[LZ_HASH_SIZE];	 // lz_compress()의 해시 테이블
+static uint8_t zswap_buf[ZSWAP_MAX_LEN];	 // 아레나에 옮기기 전 압축 결과
+
+/* 압축 스왑 통계 (vm_anon_print_stats에서 출력) */
+static long long zswap_store_cnt;  /* 압축해 아레나에 둔 페이지 수 */
+static long long zswap_reject_cnt; /* 잘 압축되지 않아 디스크로 보낸 페이지 수 */
+static long long zswap_full_cnt;   /* 아레나에 자리가 없어 디스크로 보낸 페이지 수 */
+static long long zswap_bytes;	   /* 아레나에 둔 압축 결과의 바이트 수 합 */
+static long long zswap_hit_cnt;	   /* 아레나에서 읽어 들인 swap-in 수 */
+static long long disk_in_cnt;	   /* swap 디스크에서 읽어 들인 swap-in 수 */
+
+static bool zswap_store(struct anon_page *anon_page, const void *kva);
+static bool zswap_load(struct anon_page *anon_page, void *kva);
+static void zswap_free(size_t index);
 
 /* DO NOT MODIFY this struct */
 static const struct page_operations anon_ops = {
@@ -24,13 +102,294 @@ static const struct page_operations anon_ops = {
 /* Initialize the data for anonymous pages */
 void vm_anon_init(void)
 {
+	// swap 디스크가 없으면 슬롯 0개짜리 swap으로 두고 압축 스왑만 쓴다
 	swap_disk = disk_get(1, 1);
-	swap_table = bitmap_create(disk_size(swap_disk) / (PGSIZE / DISK_SECTOR_SIZE));
+	size_t slot_cnt = swap_disk != NULL ? disk_size(swap_disk) / SECTORS_PER_SLOT : 0;
+	swap_table = bitmap_create(slot_cnt);
 	if (swap_table == NULL)
-		// PANIC("vm_anon_init: cannot create swap bitmap");
-		printf("vm_anon_init: cannot create swap bitmap");
+		PANIC("vm_anon_init: cannot create swap bitmap");
+
+	swap_refs = calloc(slot_cnt, sizeof(*swap_refs));
+	if (swap_refs == NULL && slot_cnt > 0)
+		PANIC("vm_anon_init: cannot create swap reference counts");
+	lock_init(&swap_lock);
+	swap_cursor = cluster_next = cluster_end = swap_used = 0;
+
+	lock_init(&swap_batch_lock);
+	swap_batch_buf = palloc_get_multiple(PAL_ASSERT, SWAP_CLUSTER);
+	swap_batch_base = BITMAP_ERROR;
+	swap_batch_cnt = 0;
+
+	// 압축 스왑 아레나. 연속된 페이지를 얻지 못하면 반씩 줄여 본다
+	lock_init(&zswap_lock);
+	while (vm_zswap_pages > 0 && (zswap_arena = palloc_get_multiple(0, vm_zswap_pages)) == NULL)
+		vm_zswap_pages /= 2;
+	if (zswap_arena != NULL) {
+		zswap_map = bitmap_create(vm_zswap_pages * PGSIZE / ZSWAP_CHUNK);
+		if (zswap_map == NULL)
+			PANIC("vm_anon_init: cannot create compressed swap bitmap");
+	}
+	zswap_cursor = 0;
+}
+
+/* 압축 스왑 통계를 출력한다. */
+void vm_anon_print_stats(void)
+{
+	size_t used = zswap_map != NULL ? bitmap_count(zswap_map, 0, bitmap_size(zswap_map), true) : 0;
+	long long ratio = zswap_bytes > 0 ? zswap_store_cnt * PGSIZE * 100 / zswap_bytes : 0;
+	long long swap_in = zswap_hit_cnt + disk_in_cnt;
+
+	printf("VM: zswap %zu/%zu kB used, %lld pages stored (ratio %lld.%02lld), "
+		   "%lld incompressible, %lld arena full\n",
+		   used * ZSWAP_CHUNK / 1024, vm_zswap_pages * PGSIZE / 1024, zswap_store_cnt,
+		   ratio / 100, ratio % 100, zswap_reject_cnt, zswap_full_cnt);
+	printf("VM: swap-ins %lld from zswap, %lld from disk (%lld%% zswap hits)\n", zswap_hit_cnt,
+		   disk_in_cnt, swap_in > 0 ? zswap_hit_cnt * 100 / swap_in : 0);
+	printf("VM: swap cache %zu slots in use, %lld clean swap-outs skipped, %lld swap writes\n",
+		   swap_used, swap_cache_hit_cnt, swap_write_cnt);
+	printf("VM: swap writes issued as %lld disk commands\n", swap_write_io_cnt);
+}
+
+/* KVA의 페이지를 압축해 아레나에 둔다. 압축 결과가 ZSWAP_MAX_LEN보다 크거나
+ * 아레나에 연속된 자리가 없으면 false를 반환하며, 그때는 디스크에 써야 한다. */
+static bool zswap_store(struct anon_page *anon_page, const void *kva)
+{
+	if (zswap_arena == NULL)
+		return false;
+
+	lock_acquire(&zswap_lock);
+	size_t len = lz_compress(kva, PGSIZE, zswap_buf, ZSWAP_MAX_LEN, zswap_hash);
+	if (len == 0) {
+		zswap_reject_cnt++;
+		lock_release(&zswap_lock);
+		return false;
+	}
+
+	size_t chunk_cnt = DIV_ROUND_UP(sizeof(struct zswap_entry) + len, ZSWAP_CHUNK);
+	size_t index = bitmap_scan_and_flip(zswap_map, zswap_cursor, chunk_cnt, false);
+	if (index == BITMAP_ERROR)
+		index = bitmap_scan_and_flip(zswap_map, 0, chunk_cnt, false);
+	if (index == BITMAP_ERROR) {
+		zswap_full_cnt++;
+		lock_release(&zswap_lock);
+		return false;
+	}
+	zswap_cursor = index + chunk_cnt;
+
+	struct zswap_entry *entry = (struct zswap_entry *)(zswap_arena + index * ZSWAP_CHUNK);
+	entry->len = len;
+	entry->refs = 1;
+	memcpy(entry->data, zswap_buf, len);
+	zswap_store_cnt++;
+	zswap_bytes += len;
+	lock_release(&zswap_lock);
+
+	anon_page->zswap_index = index;
+	return true;
+}
 
-	bitmap_set_all(swap_table, false);
+/* 아레나에 있는 ANON_PAGE의 내용을 KVA에 풀고 항목의 참조를 놓는다. */
+static bool zswap_load(struct anon_page *anon_page, void *kva)
+{
+	size_t index = anon_page->zswap_index;
+
+	lock_acquire(&zswap_lock);
+	struct zswap_entry *entry = (struct zswap_entry *)(zswap_arena + index * ZSWAP_CHUNK);
+	bool success = lz_decompress(entry->data, entry->len, kva, PGSIZE);
+	lock_release(&zswap_lock);
+
+	zswap_free(index);
+	anon_page->zswap_index = BITMAP_ERROR;
+	zswap_hit_cnt++;
+	return success;
+}
+
+/* 아레나 항목 INDEX의 참조 하나를 놓는다. 마지막 참조였다면 청크들을 반납한다. */
+static void zswap_free(size_t index)
+{
+	lock_acquire(&zswap_lock);
+	struct zswap_entry *entry = (struct zswap_entry *)(zswap_arena + index * ZSWAP_CHUNK);
+	ASSERT(entry->refs > 0);
+	if (--entry->refs == 0) {
+		size_t chunk_cnt = DIV_ROUND_UP(sizeof(struct zswap_entry) + entry->len, ZSWAP_CHUNK);
+		bitmap_set_multiple(zswap_map, index, chunk_cnt, false);
+	}
+	lock_release(&zswap_lock);
+}
+
+/* 스왑 슬롯 하나를 할당한다. 없으면 BITMAP_ERROR.
+ * 현재 클러스터에 남은 슬롯을 앞에서부터 내주고, 다 쓰면 커서 위치부터
+ * 비어 있는 SWAP_CLUSTER개 연속 구간을 새 클러스터로 잡는다 (next-fit).
+ * 연속 구간이 없을 만큼 조각났으면 아무 빈 슬롯이나 하나 준다. */
+static size_t swap_slot_alloc(void)
+{
+	size_t slot_cnt = bitmap_size(swap_table);
+	size_t slot;
+
+	lock_acquire(&swap_lock);
+	while (cluster_next < cluster_end) {
+		slot = cluster_next++;
+		if (!bitmap_test(swap_table, slot))
+			goto found;
+	}
+
+	slot = bitmap_scan(swap_table, swap_cursor, SWAP_CLUSTER, false);
+	if (slot == BITMAP_ERROR)
+		slot = bitmap_scan(swap_table, 0, SWAP_CLUSTER, false);
+	if (slot != BITMAP_ERROR) {
+		cluster_next = slot + 1;
+		cluster_end = slot + SWAP_CLUSTER;
+		swap_cursor = cluster_end % slot_cnt;
+		goto found;
+	}
+
+	slot = bitmap_scan(swap_table, swap_cursor, 1, false);
+	if (slot == BITMAP_ERROR)
+		slot = bitmap_scan(swap_table, 0, 1, false);
+	if (slot == BITMAP_ERROR) {
+		lock_release(&swap_lock);
+		return BITMAP_ERROR;
+	}
+	swap_cursor = (slot + 1) % slot_cnt;
+
+found:
+	bitmap_mark(swap_table, slot);
+	swap_refs[slot] = 1;
+	swap_used++;
+	lock_release(&swap_lock);
+	return slot;
+}
+
+/* 비어 있는 SWAP_CLUSTER개 연속 슬롯을 찾아 모두 사용 중으로 표시하고 첫 슬롯을 반환한다.
+ * 슬롯마다 참조 하나를 호출자가 갖는다. 그런 구간이 없으면 BITMAP_ERROR. */
+static size_t swap_cluster_reserve(void)
+{
+	lock_acquire(&swap_lock);
+	size_t slot = bitmap_scan_and_flip(swap_table, swap_cursor, SWAP_CLUSTER, false);
+	if (slot == BITMAP_ERROR)
+		slot = bitmap_scan_and_flip(swap_table, 0, SWAP_CLUSTER, false);
+	if (slot != BITMAP_ERROR) {
+		for (size_t i = slot; i < slot + SWAP_CLUSTER; i++)
+			swap_refs[i] = 1;
+		swap_used += SWAP_CLUSTER;
+		swap_cursor = (slot + SWAP_CLUSTER) % bitmap_size(swap_table);
+	}
+	lock_release(&swap_lock);
+	return slot;
+}
+
+/* 스왑 슬롯 SLOT의 참조 하나를 놓는다. 마지막 참조였다면 슬롯을 반납한다. */
+static void swap_slot_free(size_t slot)
+{
+	lock_acquire(&swap_lock);
+	ASSERT(swap_refs[slot] > 0);
+	if (--swap_refs[slot] == 0) {
+		bitmap_reset(swap_table, slot);
+		swap_used--;
+	}
+	lock_release(&swap_lock);
+}
+
+/* 스왑 캐시. 읽어 들인 페이지도 슬롯을 계속 가리키게 두어, 수정되지 않은 채 다시 쫓겨나면
+ * 디스크에 쓰지 않고 버릴 수 있게 한다. swap 공간이 절반 넘게 차 있으면 슬롯을 바로 반납한다. */
+static void swap_cache_keep(struct anon_page *anon_page)
+{
+	lock_acquire(&swap_lock);
+	bool full = swap_used * 2 > bitmap_size(swap_table);
+	lock_release(&swap_lock);
+
+	if (full) {
+		swap_slot_free(anon_page->swap_table_index);
+		anon_page->swap_table_index = BITMAP_ERROR;
+	}
+}
+
+/* 스왑 슬롯 SLOT의 내용을 KVA로 읽는다. 페이지 한 장을 명령 하나로 읽되,
+ * pageout 묶음에 있어 아직 디스크에 쓰이지 않은 슬롯이라면 묶음의 버퍼에서 복사한다. */
+static void swap_read(size_t slot, void *kva)
+{
+	lock_acquire(&swap_batch_lock);
+	if (swap_batch_base != BITMAP_ERROR && slot - swap_batch_base < swap_batch_cnt) {
+		memcpy(kva, swap_batch_buf + (slot - swap_batch_base) * PGSIZE, PGSIZE);
+		lock_release(&swap_batch_lock);
+		return;
+	}
+	lock_release(&swap_batch_lock);
+
+	disk_read_multiple(swap_disk, slot * SECTORS_PER_SLOT, kva, SECTORS_PER_SLOT);
+}
+
+/* 현재 스레드가 내보내는 anon 페이지를 디스크에 바로 쓰지 않고 묶음에 모은다.
+ * pageout 데몬이 부르며, anon_swap_batch_end()까지 이 스레드의 swap_out()이 묶음에 들어간다. */
+void anon_swap_batch_begin(void)
+{
+	lock_acquire(&swap_batch_lock);
+	ASSERT(swap_batch_owner == NULL);
+	swap_batch_owner = thread_current();
+	lock_release(&swap_batch_lock);
+}
+
+/* 모아 둔 묶음을 쓰고 묶음 모으기를 끝낸다. */
+void anon_swap_batch_end(void)
+{
+	lock_acquire(&swap_batch_lock);
+	ASSERT(swap_batch_owner == thread_current());
+	swap_batch_write();
+	swap_batch_owner = NULL;
+	lock_release(&swap_batch_lock);
+}
+
+/* KVA의 내용을 묶음에 복사하고 예약한 클러스터의 다음 슬롯을 ANON_PAGE에 배정한다.
+ * 현재 스레드가 묶음을 모으는 중이 아니거나 빈 클러스터를 예약할 수 없으면 false를 반환하며,
+ * 그때는 호출자가 직접 써야 한다. 클러스터가 차 있으면 먼저 쓴다. */
+static bool swap_batch_add(struct anon_page *anon_page, const void *kva)
+{
+	if (swap_batch_owner != thread_current())
+		return false;
+
+	lock_acquire(&swap_batch_lock);
+	if (swap_batch_cnt == SWAP_CLUSTER)
+		swap_batch_write();
+	if (swap_batch_base == BITMAP_ERROR)
+		swap_batch_base = swap_cluster_reserve();
+	if (swap_batch_base == BITMAP_ERROR) {
+		lock_release(&swap_batch_lock);
+		return false;
+	}
+
+	size_t slot = swap_batch_base + swap_batch_cnt;
+	memcpy(swap_batch_buf + swap_batch_cnt * PGSIZE, kva, PGSIZE);
+	swap_batch_cnt++;
+
+	lock_acquire(&swap_lock);
+	swap_refs[slot]++;
+	lock_release(&swap_lock);
+	anon_page->swap_table_index = slot;
+	lock_release(&swap_batch_lock);
+	return true;
+}
+
+/* 묶음에 모인 페이지들을 연속된 슬롯 구간 그대로 disk_write_multiple 한 번으로 쓰고,
+ * 묶음이 갖고 있던 슬롯 참조를 모두 놓는다. 배정하지 않은 슬롯은 이때 반납된다.
+ * swap_batch_lock을 잡고 호출한다. 쓰는 동안 락을 잡고 있으므로 그 슬롯들을 읽으려는
+ * swap-in은 쓰기가 끝난 뒤 디스크에서 읽는다. */
+static void swap_batch_write(void)
+{
+	ASSERT(lock_held_by_current_thread(&swap_batch_lock));
+
+	if (swap_batch_base == BITMAP_ERROR)
+		return;
+
+	if (swap_batch_cnt > 0) {
+		disk_write_multiple(swap_disk, swap_batch_base * SECTORS_PER_SLOT, swap_batch_buf,
+							swap_batch_cnt * SECTORS_PER_SLOT);
+		swap_write_cnt += swap_batch_cnt;
+		swap_write_io_cnt++;
+	}
+	for (size_t i = 0; i < SWAP_CLUSTER; i++)
+		swap_slot_free(swap_batch_base + i);
+	swap_batch_base = BITMAP_ERROR;
+	swap_batch_cnt = 0;
 }
 
 /* Initialize the file mapping */
@@ -41,69 +400,177 @@ bool anon_initializer(struct page *page, enum vm_type type, void *kva)
 
 	struct anon_page *anon_page = &page->anon;
 	anon_page->swap_table_index = BITMAP_ERROR;
+	anon_page->zswap_index = BITMAP_ERROR;
+	anon_page->readahead = false;
+	anon_page->zero = false;
 	return true;
 }
 
-/* Swap in the page by read contents from the swap disk. */
+/* Swap in the page by read contents from the swap disk.
+ * 압축 스왑 아레나에 있는 페이지는 디스크 대신 아레나에서 푼다.
+ * 디스크에서 읽은 페이지는 스왑 캐시로 슬롯을 남겨 둔다. */
 static bool anon_swap_in(struct page *page, void *kva)
 {
 	struct anon_page *anon_page = &page->anon;
 	size_t bitmap_index = anon_page->swap_table_index;
 
+	// zero 프레임을 보던 페이지에 처음 쓰는 경우. 새 프레임은 이미 0으로 채워져 있다
+	if (anon_page->zero) {
+		anon_page->zero = false;
+		return true;
+	}
+
+	if (anon_page->zswap_index != BITMAP_ERROR)
+		return zswap_load(anon_page, kva);
+
 	if (bitmap_index == BITMAP_ERROR)
 		return false;
 
-	disk_sector_t start_disk_sec = bitmap_index * 8;
-	for (int i = 0; i < (PGSIZE / DISK_SECTOR_SIZE); i++) {
-		disk_read(swap_disk, (start_disk_sec + i), kva + (DISK_SECTOR_SIZE * i));
-	}
+	swap_read(bitmap_index, kva);
+	disk_in_cnt++;
 
-	bitmap_set(swap_table, bitmap_index, false);
-	anon_page->swap_table_index = BITMAP_ERROR;
+	swap_cache_keep(anon_page);
 	return true;
 }
 
-/* Swap out the page by writing contents to the swap disk. */
+/* 스왑 슬롯의 내용을 KVA로 읽되 슬롯은 반납하지 않는다 (swap readahead).
+ * 실제로 쓰이기 전까지는 슬롯과 내용이 같으므로 다시 쓰지 않고 버릴 수 있다. */
+bool anon_swap_readahead(struct page *page, void *kva)
+{
+	struct anon_page *anon_page = &page->anon;
+	size_t bitmap_index = anon_page->swap_table_index;
+
+	if (bitmap_index == BITMAP_ERROR)
+		return false;
+
+	swap_read(bitmap_index, kva);
+	anon_page->readahead = true;
+	return true;
+}
+
+/* 방금 내보낸 SRC와 프레임을 공유하던 PAGE가 SRC의 스왑 슬롯(또는 압축 스왑 항목)을
+ * 함께 가리키게 한다. 각자 다시 읽어 들일 때 자기 참조를 놓는다.
+ * PAGE가 스왑 캐시로 갖고 있던 슬롯은 SRC의 것에 참조를 더한 뒤에 놓는다. */
+void anon_swap_share(struct page *page, struct page *src)
+{
+	size_t old_slot = page->anon.swap_table_index;
+	size_t index = src->anon.zswap_index;
+	size_t slot = src->anon.swap_table_index;
+
+	if (index != BITMAP_ERROR) {
+		lock_acquire(&zswap_lock);
+		((struct zswap_entry *)(zswap_arena + index * ZSWAP_CHUNK))->refs++;
+		lock_release(&zswap_lock);
+		page->anon.zswap_index = index;
+		slot = BITMAP_ERROR;
+	} else if (slot != BITMAP_ERROR) {
+		lock_acquire(&swap_lock);
+		swap_refs[slot]++;
+		lock_release(&swap_lock);
+	}
+	page->anon.swap_table_index = slot;
+
+	if (old_slot != BITMAP_ERROR)
+		swap_slot_free(old_slot);
+}
+
+/* readahead로 읽어 둔 페이지가 매핑되었다. 이제부터는 읽어 들인 페이지와 같이
+ * 스왑 캐시로 슬롯을 남겨 두고, 수정되었는지는 dirty 비트로 판단한다. */
+void anon_readahead_settle(struct page *page)
+{
+	struct anon_page *anon_page = &page->anon;
+
+	if (!anon_page->readahead)
+		return;
+
+	anon_page->readahead = false;
+	swap_cache_keep(anon_page);
+}
+
+/* Swap out the page by writing contents to the swap disk.
+ * 스왑 캐시의 슬롯이 남아 있고 수정되지 않았다면 쓰지 않는다.
+ * 먼저 압축 스왑 아레나에 넣어 보고, 들어가지 않을 때만 디스크에 쓴다. */
 static bool anon_swap_out(struct page *page)
 {
 	struct anon_page *anon_page = &page->anon;
 
-	if (anon_page->swap_table_index != BITMAP_ERROR)
+	// 읽어 둔 뒤 쓰이지 않았다면 슬롯에 같은 내용이 있으므로 쓰지 않는다
+	if (anon_page->readahead) {
+		anon_page->readahead = false;
+		return true;
+	}
+
+	// 교체 중에는 매핑이 먼저 지워지므로 그 전에 모아 둔 dirty_hint도 본다
+	if (anon_page->swap_table_index != BITMAP_ERROR) {
+		uint64_t *pml4 = page->owner_thread->pml4;
+		if (!page->frame->dirty_hint && !pml4_is_dirty(pml4, page->va)) {
+			swap_cache_hit_cnt++;
+			return true;
+		}
+		// 수정되었으므로 슬롯의 내용은 낡았다. 새로 내보낸다
+		swap_slot_free(anon_page->swap_table_index);
+		anon_page->swap_table_index = BITMAP_ERROR;
+	}
+	if (anon_page->zswap_index != BITMAP_ERROR)
 		return false;
 
-	size_t bitmap_index = bitmap_scan_and_flip(swap_table, 0, 1, false);
+	if (zswap_store(anon_page, page->frame->kva))
+		return true;
+
+	// pageout 데몬이 내보내는 페이지는 묶음에 모았다가 한꺼번에 쓴다
+	if (swap_batch_add(anon_page, page->frame->kva))
+		return true;
+
+	size_t bitmap_index = swap_slot_alloc();
 	if (bitmap_index == BITMAP_ERROR)
 		return false;
 
-	disk_sector_t start_disk_sec = bitmap_index * 8;
-	for (int i = 0; i < (PGSIZE / DISK_SECTOR_SIZE); i++) {
-		disk_write(swap_disk, (start_disk_sec + i), page->frame->kva + (DISK_SECTOR_SIZE * i));
-	}
+	// 페이지 한 장을 명령 하나로 쓴다
+	disk_write_multiple(swap_disk, bitmap_index * SECTORS_PER_SLOT, page->frame->kva,
+						SECTORS_PER_SLOT);
+	swap_write_cnt++;
+	swap_write_io_cnt++;
 
 	anon_page->swap_table_index = bitmap_index;
 	return true;
 }
 
+/* 파일 없는 mmap (fd -1). [addr, addr + length)를 anon 영역으로 등록한다.
+ * 페이지는 처음 접근할 때 0으로 채워지며, 읽기만 한 페이지는 공용 zero 프레임을 본다. */
+void *do_mmap_anon(void *addr, size_t length, int writable)
+{
+	struct vma tmpl = {
+		.start = addr,
+		.end = pg_round_up(addr + length),
+		.type = VM_ANON,
+		.writable = writable,
+		.mapped = true,
+		.fault_around = VM_FAULT_AROUND_DEFAULT,
+	};
+	if (vma_insert(&thread_current()->spt, &tmpl) == NULL)
+		return NULL;
+	return addr;
+}
+
 /* Destroy the anonymous page. PAGE will be freed by the caller. */
 static void anon_destroy(struct page *page)
 {
 	struct anon_page *anon_page = &page->anon;
 
-	// swap disk 있으면 해제
+	// pte에서 매핑 제거. zero 프레임에 매핑된 페이지도 pml4_destroy()가 해제하지 않도록 지운다
+	pml4_clear_page(thread_current()->pml4, page->va);
+
+	// 프레임 참조를 놓는다 (마지막 참조면 물리메모리도 제거)
+	if (page->frame != NULL)
+		vm_free_frame(page);
+
+	// swap disk 있으면 해제. pageout 데몬이 그 사이 내보냈을 수 있으므로 프레임을 놓은 뒤에 본다
 	if (anon_page->swap_table_index != BITMAP_ERROR) {
-		bitmap_set(swap_table, anon_page->swap_table_index, false);
+		swap_slot_free(anon_page->swap_table_index);
 		anon_page->swap_table_index = BITMAP_ERROR;
 	}
-
-	if (page->frame != NULL) {
-		// pte에서 매핑 제거
-		pml4_clear_page(thread_current()->pml4, page->va);
-
-		// 물리메모리도 제거
-		palloc_free_page(page->frame->kva);
-
-		// frame 구조체 해제
-		free(page->frame);
-		page->frame = NULL;
+	if (anon_page->zswap_index != BITMAP_ERROR) {
+		zswap_free(anon_page->zswap_index);
+		anon_page->zswap_index = BITMAP_ERROR;
 	}
 }
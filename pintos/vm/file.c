@@ -1,8 +1,8 @@
 /* file.c: Implementation of memory backed file object (mmaped object). */
 
 #include "vm/vm.h"
+#include "threads/malloc.h"
 #include "threads/vaddr.h"
-#include "userprog/syscall.h"
 
 static bool file_backed_swap_in(struct page *page, void *kva);
 static bool file_backed_swap_out(struct page *page);
@@ -39,8 +39,7 @@ bool file_backed_initializer(struct page *page, enum vm_type type, void *kva)
 		.offset = aux->offset,
 		.file = aux->file,
 		.page_read_bytes = aux->page_read_bytes,
-		.mmap_index = aux->mmap_index,
-		.mmap_length = aux->mmap_length,
+		.shared = aux->shared,
 	};
 
 	return true;
@@ -60,9 +59,7 @@ static bool file_backed_swap_in(struct page *page, void *kva)
 	off_t ofs = file_page->offset;
 	size_t page_read_bytes = file_page->page_read_bytes;
 
-	lock_acquire(&file_lock);
 	int result = file_read_at(file, page->frame->kva, page_read_bytes, ofs);
-	lock_release(&file_lock);
 
 	if (result != file_page->page_read_bytes) {
 		// 파일 쓰기에 실패했다면 OS가 할 수 있는 일은 없다.
@@ -81,15 +78,21 @@ static bool file_backed_swap_out(struct page *page)
 		return false;
 
 	struct file_page *file_page = &page->file;
-	bool is_dirty = pml4_is_dirty(thread_current()->pml4, page->va);
+
+	// 실행 파일 세그먼트는 읽기 전용이므로 쓰지 않고 버리기만 한다
+	if (file_page->shared)
+		return true;
+
+	// pageout 데몬이나 다른 프로세스가 내보낼 수도 있으므로 소유자의 페이지 테이블을 본다.
+	// 교체 중에는 매핑이 먼저 지워지므로 그 전에 모아 둔 dirty_hint도 본다
+	uint64_t *pml4 = page->owner_thread->pml4;
+	bool is_dirty = page->frame->dirty_hint || pml4_is_dirty(pml4, page->va);
 	if (is_dirty) {
 		struct file *file = file_page->file;
 		off_t ofs = file_page->offset;
 		size_t page_read_bytes = file_page->page_read_bytes;
 
-		lock_acquire(&file_lock);
 		off_t result = file_write_at(file, page->frame->kva, page_read_bytes, ofs);
-		lock_release(&file_lock);
 
 		if (result != file_page->page_read_bytes) {
 			// 파일 쓰기에 실패했다면 OS가 할 수 있는 일은 없다.
@@ -98,81 +101,76 @@ static bool file_backed_swap_out(struct page *page)
 		}
 	}
 
-	pml4_set_dirty(thread_current()->pml4, page->va, false);
+	pml4_set_dirty(pml4, page->va, false);
 	return true;
 }
 
 /* Destory the file backed page. PAGE will be freed by the caller. */
 static void file_backed_destroy(struct page *page)
 {
-	struct file_page *file_page = &page->file;
-	if (page->frame == NULL)
+	// 쓰는 동안 교체되거나 다른 스레드가 같은 프레임을 내보내지 않도록 프레임 락을 잡는다
+	struct frame *frame = vm_frame_lock(page);
+	if (frame == NULL)
 		return;
 
 	file_backed_swap_out(page);
 
 	// pte에서 매핑 제거
 	pml4_clear_page(thread_current()->pml4, page->va);
+	vm_frame_unlock(frame);
 
-	// 물리메모리도 해제
-	palloc_free_page(page->frame->kva);
-	free(page->frame);
-	page->frame = NULL;
+	// 프레임 참조를 놓는다 (마지막 참조면 물리메모리도 해제)
+	vm_free_frame(page);
 }
 
-/*
-mummap을 위해 mmap시 페이지의 index와 mmap 페이지의 길이를 추가한다.
-file과 aux객체에 해당 내용을 저장하여 mummap시 index와 mmap페이지 길이를 보고 mummap을 진행한다.
-
-munmap을 위해서 struct page에 다음 페이지를 가리키는 포인터인 next_page를 추가한다.
-일반적인 경우에는 next_page가 NULL이지만, mmap으로 할당할 때는 next_page가 다음 페이지를 가리키도록
-업데이트한다. munmap시에는, next_page가 NULL일 때까지 순회를 돌면서 해당 munmap 로직을 수행한다.
-*/
-
-/* Do the mmap */
+/* Do the mmap
+ * 파일을 다시 열어 [addr, addr + length)를 하나의 영역으로 등록한다.
+ * 페이지는 처음 접근할 때 영역에서 만들어진다. */
 void *do_mmap(void *addr, size_t length, int writable, struct file *file, off_t offset)
 {
 	file = file_reopen(file);
-	int index = 0;
-	void *addr_copy = addr;
-	size_t read_bytes = length;
-	struct page *current_page = NULL;
-
-	while (read_bytes > 0) {
-		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-
-		struct mmap_aux *mmap_aux = malloc(sizeof(*mmap_aux));
-		if (!mmap_aux)
-			return NULL;
-
-		*mmap_aux = (struct mmap_aux){
-			.file = file,
-			.offset = offset,
-			.page_read_bytes = page_read_bytes,
-			.mmap_index = index++,						   // mmap 중에 몇번재
-			.mmap_length = (length + PGSIZE - 1) / PGSIZE, // mmap 총 몇페이지
-		};
-
-		if (!vm_alloc_page_with_initializer(VM_FILE, addr_copy, writable, lazy_load_file,
-											mmap_aux)) {
-			free(mmap_aux);
-			mmap_aux = NULL;
-			goto error;
-		}
-
-		addr_copy += PGSIZE;
-		offset += page_read_bytes;
-		read_bytes -= page_read_bytes;
+	if (file == NULL)
+		return NULL;
+
+	struct vma tmpl = {
+		.start = addr,
+		.end = pg_round_up(addr + length),
+		.type = VM_FILE,
+		.writable = writable,
+		.init = lazy_load_file,
+		.file = file,
+		.offset = offset,
+		.read_bytes = length,
+		.owns_file = true,
+		.mapped = true,
+		.fault_around = VM_FAULT_AROUND_DEFAULT,
+	};
+	if (vma_insert(&thread_current()->spt, &tmpl) == NULL) {
+		file_close(file);
+		return NULL;
 	}
 	return addr;
+}
 
-error:
-	for (size_t i = 0; i < length; i += PGSIZE) {
-		struct page *rollback_page = spt_find_page(&thread_current()->spt, addr + i);
-		if (rollback_page != NULL)
-			destroy(rollback_page);
-	}
-	return NULL;
+/* 실행 파일의 읽기 전용 세그먼트를 UPAGE부터 하나의 영역으로 등록한다.
+ * mmap과 같은 파일 페이지로 lazy loading 되지만, 같은 (inode, offset) 페이지를 읽는
+ * 프로세스끼리는 vm.c의 text cache를 통해 프레임을 공유한다. */
+bool vm_map_text_segment(void *upage, struct file *file, off_t offset, size_t read_bytes,
+						 size_t zero_bytes)
+{
+	struct vma tmpl = {
+		.start = upage,
+		.end = upage + read_bytes + zero_bytes,
+		.type = VM_FILE,
+		.writable = false,
+		.init = lazy_load_file,
+		.file = file,
+		.offset = offset,
+		.read_bytes = read_bytes,
+		.shared = true,
+		.fault_around = VM_FAULT_AROUND_DEFAULT,
+	};
+	return vma_insert(&thread_current()->spt, &tmpl) != NULL;
 }
 
 static bool lazy_load_file(struct page *page, void *aux)
@@ -182,9 +180,7 @@ static bool lazy_load_file(struct page *page, void *aux)
 	off_t ofs = mmap_aux->offset;
 	size_t page_read_bytes = mmap_aux->page_read_bytes;
 
-	lock_acquire(&file_lock);
 	int read_result = file_read_at(file, page->frame->kva, page_read_bytes, ofs);
-	lock_release(&file_lock);
 
 	page->file.page_read_bytes = read_result;
 	memset(page->frame->kva + read_result, 0, PGSIZE - read_result);
@@ -193,28 +189,40 @@ static bool lazy_load_file(struct page *page, void *aux)
 	return true;
 }
 
-/* Do the munmap */
+/* Do the munmap
+ * ADDR에서 시작하는 mmap 영역을 없앤다. 수정된 페이지는 파일에 다시 쓴다. */
 void do_munmap(void *addr)
 {
-	struct page *mmap_page = spt_find_page(&thread_current()->spt, addr);
-	if (mmap_page == NULL || page_get_type(mmap_page) != VM_FILE)
-		return;
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	struct vma *vma = vma_find(spt, addr);
 
-	struct file *mmap_file = mmap_page->file.file;
+	// 실행 파일 세그먼트와 힙은 mmap으로 만든 영역이 아니다
+	if (vma == NULL || vma->start != addr || !vma->mapped)
+		return;
 
-	int length;
-	if (VM_TYPE(mmap_page->operations->type) == VM_FILE) {
-		length = mmap_page->file.mmap_length;
-	} else {
-		struct mmap_aux *mmap_aux = mmap_page->uninit.aux;
-		length = mmap_aux->mmap_length;
-	}
+	// dirty 페이지를 이어지는 구간끼리 묶어 먼저 쓰고 나면 페이지를 지울 때는 쓸 것이 없다
+	vm_writeback_range(vma->start, vma->end);
+	vma_remove(spt, vma);
+}
 
-	for (size_t i = 0; i < length; i++) {
-		struct page *page = spt_find_page(&thread_current()->spt, addr + (PGSIZE * i));
-		ASSERT(page != NULL);
-		spt_remove_page(&thread_current()->spt, page);
+/* Do the msync
+ * [addr, addr + length)와 겹치는 mmap 영역의 dirty 페이지를 파일에 쓴다.
+ * SYNC가 false면 flusher에게 맡기고 바로 돌아온다. 범위 안에 매핑되지 않은 곳이 있으면 false. */
+bool do_msync(void *addr, size_t length, bool sync)
+{
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	void *end = pg_round_up(addr + length);
+
+	for (void *va = addr; va < end;) {
+		struct vma *vma = vma_find(spt, va);
+		if (vma == NULL)
+			return false;
+		va = vma->end;
 	}
 
-	file_close(mmap_file); // TODO: exit 시 file_close
+	if (sync)
+		vm_writeback_range(addr, end);
+	else
+		vm_writeback_async();
+	return true;
 }
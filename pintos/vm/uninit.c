@@ -52,6 +52,18 @@ static bool uninit_initialize(struct page *page, void *kva)
 	return uninit->page_initializer(page, uninit->type, kva) && (init ? init(page, aux) : true);
 }
 
+/* init 콜백을 부르지 않고 페이지를 실제 타입의 페이지 객체로만 바꾼다.
+ * 이미 내용이 채워진 프레임을 공유해서 매핑할 때 쓴다. aux는 더 쓰이지 않으므로 해제한다. */
+bool uninit_transmute(struct page *page, void *kva)
+{
+	struct uninit_page *uninit = &page->uninit;
+	void *aux = uninit->aux;
+
+	bool success = uninit->page_initializer(page, uninit->type, kva);
+	free(aux);
+	return success;
+}
+
 /* Free the resources hold by uninit_page. Although most of pages are transmuted
  * to other page objects, it is possible to have uninit pages when the process
  * exit, which are never referenced during the execution.
@@ -62,4 +74,7 @@ static void uninit_destroy(struct page *page)
 
 	free(uninit->aux);
 	uninit->aux = NULL;
+
+	// fault-around로 미리 읽어 둔 프레임이 있다면 놓는다 (매핑은 되어 있지 않다)
+	vm_free_frame(page);
 }
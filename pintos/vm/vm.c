@@ -1,18 +1,176 @@
 /* vm.c: Generic interface for virtual memory objects. */
 
 #include "vm/vm.h"
+#include "devices/timer.h"
 #include "threads/malloc.h"
 #include "threads/mmu.h"
+#include "threads/pte.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
 #include "threads/vaddr.h"
 #include "vm/inspect.h"
+#include <bitmap.h>
+#include <hash.h>
+#include <round.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
 
-static struct list frame_list;
+/* 프레임 테이블. 유저 풀의 페이지 번호로 색인하는 배열이다.
+ * frame_table[i]는 유저 풀의 i번째 페이지(frame_base + i * PGSIZE)를 나타낸다. */
+static struct frame *frame_table;
+static size_t frame_cnt;
+static void *frame_base;
+/* 프레임 테이블의 짧은 상태(page_list 연결, pin_cnt, 시계 바늘, 여유 프레임 수, text cache)를
+ * 보호한다. 잡은 채로 I/O를 하거나 프레임 락을 기다리지 않는다. 프레임 락과 함께 잡을 때는
+ * 프레임 락을 먼저 잡고, 반대 순서가 필요하면 lock_try_acquire()로만 잡는다. */
 static struct lock frame_table_lock;
 
+/* clock 알고리즘의 시계 바늘. 다음에 검사할 frame_table의 인덱스. */
+static size_t clock_hand;
+
+/* 아직 쓰인 적 없는 anon 페이지를 읽을 때 읽기 전용으로 매핑해 주는 공용 zero 프레임.
+ * 커널 풀에서 할당하며 프레임 테이블에 속하지 않는다. */
+static void *zero_kva;
+
+/* zero 프레임을 읽기 전용으로 pin하는 vm_pin_user()에 돌려주는 프레임. kva만 zero_kva를 가리키고
+ * page_list는 비어 있으며 프레임 테이블 밖에 있어 교체되지 않는다. */
+static struct frame zero_frame;
+
+/* 유저 풀에 남아 있는 프레임 수. frame_table_lock으로 보호한다. */
+static size_t free_frame_cnt;
+
+/* pageout 데몬. 여유 프레임이 vm_pageout_low 아래로 내려가면 깨어나
+ * vm_pageout_high개가 될 때까지 차가운 프레임을 미리 내보낸다.
+ * 그래서 fault 경로는 대부분 바로 빈 프레임을 얻는다. */
+size_t vm_pageout_low;
+size_t vm_pageout_high;
+static struct semaphore pageout_sema;
+static bool pageout_running; /* 데몬이 깨어 있거나 깨우는 중이면 true (frame_table_lock) */
+
+/* MADV_WILLNEED 요청. madvise()를 부른 스레드가 범위 안에서 디스크를 읽어야 하는 페이지만 골라 담아
+ * pageout 데몬에 맡기고 바로 돌아간다. 데몬은 fault-around처럼 프레임에 내용만 채워 두고 매핑하지
+ * 않으며, 첫 접근 때 vm_map_resident()가 매핑한다. 데몬은 요청한 프로세스의 spt를 건드리지 않고,
+ * 프로세스는 페이지를 지우기 전에 willneed_cancel()로 남은 요청을 버리고 처리 중인 요청을 기다린다. */
+#define WILLNEED_MAX 256 /* 요청 하나에 담는 최대 페이지 수 */
+struct willneed_req {
+	struct list_elem elem;
+	struct supplemental_page_table *spt; /* 요청한 프로세스의 spt */
+	size_t cnt;
+	struct page *pages[WILLNEED_MAX];
+};
+static struct list willneed_queue;		  /* 처리를 기다리는 요청 (frame_table_lock) */
+static struct willneed_req *willneed_cur; /* 데몬이 처리 중인 요청 (frame_table_lock) */
+static struct condition willneed_done;	  /* willneed_cur의 처리가 끝날 때 알린다 */
+static long long willneed_read_cnt;		  /* MADV_WILLNEED로 미리 읽은 페이지 수 */
+
+/* text cache. 실행 파일의 읽기 전용 세그먼트 페이지를 프로세스 간에 공유하기 위해
+ * (inode, offset, read_bytes)로 그 내용을 담고 있는 프레임을 찾는다.
+ * frame_table_lock으로 보호한다. */
+static struct hash text_cache;
+
+struct text_cache_entry {
+	struct inode *inode;
+	off_t offset;
+	uint32_t read_bytes;
+	struct frame *frame;
+	struct hash_elem elem;
+};
+
+static uint64_t text_cache_hash_func(const struct hash_elem *elem, void *aux UNUSED);
+static bool text_cache_less_func(const struct hash_elem *elem_a, const struct hash_elem *elem_b,
+								 void *aux UNUSED);
+
+/* 교체 통계 (vm_print_stats에서 출력) */
+static long long evict_cnt;		  /* 교체된 프레임 수 */
+static long long evict_clean_cnt; /* 쓰기 없이 버려진 프레임 수 */
+static long long swap_fail_cnt;	  /* swap에 자리가 없어 내보내지 못하고 건너뛴 프레임 수 */
+static long long swap_in_cnt;	  /* 디스크/파일에서 다시 읽어 들인 페이지 수 */
+static long long text_hit_cnt;	  /* text cache에서 프레임을 찾아 공유한 횟수 */
+static long long sync_evict_cnt;  /* fault 경로에서 직접 교체한 횟수 */
+static long long pageout_cnt;	  /* pageout 데몬이 회수한 프레임 수 */
+static long long pageout_wake_cnt; /* pageout 데몬이 깨어난 횟수 */
+static long long ra_read_cnt;	   /* swap readahead로 미리 읽은 페이지 수 */
+static long long ra_hit_cnt;	   /* 그 중 교체되기 전에 접근된 페이지 수 */
+
+/* swap readahead 창 크기 (페이지 수). 적중률에 따라 MIN과 MAX 사이에서 두 배로 늘리거나 반으로 줄인다. */
+#define RA_WINDOW_MIN 1
+#define RA_WINDOW_INIT 4
+#define RA_WINDOW_MAX 32
+/* fault 난 페이지와 스왑 슬롯이 이만큼 이내로 떨어진 이웃만 미리 읽는다 */
+#define RA_SLOT_DISTANCE 32
+/* SEQUENTIAL 영역에서 fault가 난 페이지보다 이만큼 뒤에 있는 이만큼의 페이지를 먼저 내보낸다 */
+#define DROP_BEHIND RA_WINDOW_MAX
+
+static long long cow_share_cnt; /* fork 때 자식과 공유한 anon 프레임 수 */
+static long long cow_copy_cnt;	/* 공유 중인 프레임에 처음 써서 복사한 수 */
+static long long cow_reuse_cnt; /* 마지막 공유자라서 복사 없이 쓰기 권한만 되돌린 수 */
+static long long fork_copy_cnt; /* fork 때 바로 복사한 mmap 페이지 수 */
+
+static long long zero_map_cnt; /* zero 프레임을 매핑해 준 읽기 fault 수 */
+static long long zero_cow_cnt; /* 그 중 나중에 쓰여서 프레임을 할당한 수 */
+static long long fa_read_cnt; /* fault-around로 미리 읽은 페이지 수 */
+static long long fa_hit_cnt;  /* 그 중 교체되기 전에 접근된 페이지 수 */
+
+bool vm_huge_pages;
+/* 2MB 페이지 하나에 들어가는 4KB 페이지 수 */
+#define HUGE_PGCNT (HUGE_PGSIZE / PGSIZE)
+static long long huge_map_cnt; /* 2MB 페이지로 매핑한 횟수 */
+
+static long long spt_lookup_cnt; /* spt_find_page() 호출 수 */
+static long long spt_table_cnt;	 /* 지금 모든 spt가 쓰고 있는 radix 테이블 수 */
+static long long spt_table_max;	 /* 그 최댓값 */
+
+/* 아직 읽지 않은 파일 페이지(mmap, 실행 파일 세그먼트)가 읽어야 할 파일 구간 */
+struct file_extent {
+	struct file *file;
+	off_t offset;
+	uint32_t read_bytes;
+	unsigned window; /* 매핑의 fault-around 창 크기 */
+	bool shared;	 /* text cache로 공유하는 실행 파일 세그먼트 */
+};
+
+/* dirty한 mmap 페이지 writeback. flusher 스레드가 주기적으로, msync와 munmap이 필요할 때
+ * 파일에서 연속된 페이지들을 writeback_buf에 모아 한 번의 file_write_at으로 쓴다. */
+#define WB_BATCH 16					 /* 한 번에 모아 쓰는 최대 페이지 수 */
+#define WB_POLL (TIMER_FREQ / 10)	 /* flusher가 요청을 확인하는 주기 (tick) */
+#define WB_INTERVAL (TIMER_FREQ * 2) /* flusher가 요청 없이도 쓰는 주기 (tick) */
+static void *writeback_buf;			 /* WB_BATCH 페이지. writeback_lock으로 보호 */
+static struct lock writeback_lock;	 /* writeback을 한 번에 하나씩 하게 한다 */
+static bool writeback_requested;	 /* msync(MS_ASYNC)가 flusher를 재촉함 */
+static size_t flush_hand;			 /* flusher가 다음에 볼 frame_table의 인덱스 */
+
+/* writeback할 후보 페이지. FRAME에 아직 PAGE가 붙어 있을 때만 쓴다. */
+struct writeback_entry {
+	struct frame *frame;
+	struct page *page;
+	struct inode *inode; /* 정렬 키 */
+	off_t offset;
+};
+
+static long long writeback_cnt;	   /* writeback한 페이지 수 */
+static long long writeback_io_cnt; /* 그에 쓰인 file_write_at 호출 수 */
+
+/* working set 샘플러. WS_INTERVAL마다 모든 프레임의 accessed 비트를 거둬 프로세스별로
+ * 최근에 접근된 페이지 수(WSS)를 추정하고, 그 구간의 page fault 빈도(PFF)로 프레임 할당량을
+ * 조절한다. fault가 잦으면 남는 만큼 할당량을 늘리고, 드물면 WSS까지 줄인다.
+ * 할당량을 넘긴 프로세스가 있으면 교체는 그 프로세스들의 프레임부터 고른다. */
+#define WS_INTERVAL (TIMER_FREQ / 4) /* 샘플링 주기 (tick) */
+#define PFF_HIGH 64					 /* 초당 fault가 이보다 많으면 할당량을 늘린다 */
+#define PFF_LOW 8					 /* 초당 fault가 이보다 적으면 할당량을 줄인다 */
+#define PFF_STEP 16					 /* 할당량을 한 번에 바꾸는 최소 프레임 수 */
+#define PFF_MIN_QUOTA 32			 /* 할당량의 하한 */
+#define PFF_INIT_QUOTA 256			 /* 새 프로세스의 할당량 */
+bool vm_ws_report;
+static bool ws_over_quota; /* 지난 샘플링 때 할당량을 넘긴 프로세스가 있었음 */
+
+static void pageout_daemon(void *aux);
+static void flusher_daemon(void *aux);
+static void ws_daemon(void *aux);
+
 void vm_init(void)
 {
 	vm_anon_init();
@@ -22,8 +180,73 @@ void vm_init(void)
 #endif
 	register_inspect_intr();
 	/* DO NOT MODIFY UPPER LINES. */
-	list_init(&frame_list);
 	lock_init(&frame_table_lock);
+	clock_hand = 0;
+
+	// 유저 풀 크기만큼 프레임 테이블을 한 번에 할당한다
+	frame_base = palloc_user_pool_base();
+	frame_cnt = palloc_user_pool_size();
+	size_t table_pages = DIV_ROUND_UP(frame_cnt * sizeof(struct frame), PGSIZE);
+	frame_table = palloc_get_multiple(PAL_ASSERT | PAL_ZERO, table_pages);
+	for (size_t i = 0; i < frame_cnt; i++) {
+		frame_table[i].kva = frame_base + PGSIZE * i;
+		list_init(&frame_table[i].page_list);
+		lock_init(&frame_table[i].lock);
+	}
+
+	if (!hash_init(&text_cache, text_cache_hash_func, text_cache_less_func, NULL))
+		PANIC("(vm_init) text cache init FAIL!");
+
+	zero_kva = palloc_get_page(PAL_ASSERT | PAL_ZERO);
+	zero_frame.kva = zero_kva;
+	list_init(&zero_frame.page_list);
+	lock_init(&zero_frame.lock);
+
+	// 아직 유저 프로세스가 없으므로 유저 풀 전체가 비어 있다
+	free_frame_cnt = frame_cnt;
+	if (vm_pageout_low == 0)
+		vm_pageout_low = frame_cnt / 64 > 2 ? frame_cnt / 64 : 2;
+	if (vm_pageout_high <= vm_pageout_low)
+		vm_pageout_high = vm_pageout_low * 2;
+	sema_init(&pageout_sema, 0);
+	pageout_running = false;
+	list_init(&willneed_queue);
+	cond_init(&willneed_done);
+	if (thread_create("pageout", PRI_DEFAULT, pageout_daemon, NULL) == TID_ERROR)
+		PANIC("(vm_init) pageout daemon create FAIL!");
+
+	writeback_buf = palloc_get_multiple(PAL_ASSERT, WB_BATCH);
+	lock_init(&writeback_lock);
+	if (thread_create("flusher", PRI_DEFAULT, flusher_daemon, NULL) == TID_ERROR)
+		PANIC("(vm_init) flusher create FAIL!");
+
+	if (thread_create("wss", PRI_DEFAULT, ws_daemon, NULL) == TID_ERROR)
+		PANIC("(vm_init) working set sampler create FAIL!");
+}
+
+/* 교체 통계를 출력한다. */
+void vm_print_stats(void)
+{
+	printf("VM: %lld evictions (%lld clean, %lld dirty), %lld swap-ins, %lld text cache hits\n",
+		   evict_cnt, evict_clean_cnt, evict_cnt - evict_clean_cnt, swap_in_cnt, text_hit_cnt);
+	printf("VM: %lld victims skipped with swap full\n", swap_fail_cnt);
+	printf("VM: pageout %zu/%zu frames, %lld wakeups, %lld reclaimed, %lld synchronous evictions\n",
+		   vm_pageout_low, vm_pageout_high, pageout_wake_cnt, pageout_cnt, sync_evict_cnt);
+	printf("VM: readahead %lld pages, %lld hits (%lld%%)\n", ra_read_cnt, ra_hit_cnt,
+		   ra_read_cnt > 0 ? ra_hit_cnt * 100 / ra_read_cnt : 0);
+	printf("VM: fault-around %lld pages, %lld hits (%lld%%)\n", fa_read_cnt, fa_hit_cnt,
+		   fa_read_cnt > 0 ? fa_hit_cnt * 100 / fa_read_cnt : 0);
+	printf("VM: madvise willneed %lld pages read by the pageout daemon\n", willneed_read_cnt);
+	printf("VM: fork shared %lld pages copy-on-write (%lld copied later, %lld reused), "
+		   "%lld copied at fork\n",
+		   cow_share_cnt, cow_copy_cnt, cow_reuse_cnt, fork_copy_cnt);
+	printf("VM: zero page %lld read faults, %lld later written (%lld frames saved)\n",
+		   zero_map_cnt, zero_cow_cnt, zero_map_cnt - zero_cow_cnt);
+	printf("VM: %lld huge page mappings\n", huge_map_cnt);
+	printf("VM: spt %lld lookups, at most %lld radix tables (%lld KB)\n", spt_lookup_cnt,
+		   spt_table_max, spt_table_max * PGSIZE / 1024);
+	vm_anon_print_stats();
+	printf("VM: writeback %lld pages in %lld writes\n", writeback_cnt, writeback_io_cnt);
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -41,9 +264,47 @@ enum vm_type page_get_type(struct page *page)
 }
 
 /* Helpers */
+static struct page *spt_lookup_page(struct supplemental_page_table *spt, void *va);
 static struct frame *vm_get_victim(void);
 static bool vm_do_claim_page(struct page *page);
+static bool vm_handle_wp(struct page *page);
 static struct frame *vm_evict_frame(void);
+static bool frame_evict(struct frame *victim);
+static struct frame *clock_advance(void);
+static bool frame_needs_writeback(struct frame *frame);
+static bool frame_is_accessed(struct frame *frame);
+static size_t page_harvest_accessed(struct page *page);
+static bool frame_over_quota(struct frame *frame);
+static bool frame_is_dirty(struct frame *frame);
+static void frame_clear_dirty(struct frame *frame);
+static void frame_attach(struct frame *frame, struct page *page);
+static void frame_detach(struct frame *frame, struct page *page);
+static void frame_reset(struct frame *frame);
+static bool frame_try_lock(struct frame *frame);
+static void frame_free(struct frame *frame);
+static void pageout_wakeup(void);
+static struct frame *frame_alloc(enum palloc_flags flags);
+static bool frame_attach_new(struct frame *frame, struct page *page);
+static void frame_discard(struct frame *frame);
+static void pageout_reclaim(void);
+static bool page_needs_read(struct page *page);
+static struct willneed_req *willneed_next(void);
+static void willneed_run(struct willneed_req *req);
+static void willneed_finish(struct willneed_req *req);
+static void willneed_cancel(struct supplemental_page_table *spt);
+static bool vm_map_resident(struct page *page, bool *success);
+static void swap_readahead(struct page *page, size_t slot);
+static void drop_behind(struct page *page);
+static bool vm_map_zero_page(struct page *page);
+static bool vm_map_huge(struct supplemental_page_table *spt, void *addr);
+static bool page_needs_zero_frame(struct page *page);
+static bool file_extent_of(struct page *page, struct file_extent *ext);
+static void file_extent_filled(struct page *page, void *kva, int read);
+static void fault_around(struct page *page, struct file_extent *ext);
+static bool text_cache_key(struct page *page, struct text_cache_entry *key);
+static bool text_cache_map(struct page *page, struct text_cache_entry *key);
+static void text_cache_insert(struct text_cache_entry *key, struct frame *frame);
+static void text_cache_remove(struct frame *frame);
 
 /* Create the pending page object with initializer. If you want to create a
  * page, do not create it directly and make it through this function or
@@ -94,24 +355,56 @@ err:
 	return false;
 }
 
+/* spt radix tree의 단계 수와 단계별 테이블 크기. 각 단계는 pml4, pdp, pd, pt와 같은 비트를 쓴다. */
+#define SPT_LEVELS 4
+#define SPT_ENTRIES (PGSIZE / sizeof(void *))
+static const uint64_t spt_shift[SPT_LEVELS] = {PML4SHIFT, PDPESHIFT, PDXSHIFT, PTXSHIFT};
+
+#define spt_index(va, level) (((uint64_t)(va) >> spt_shift[level]) & (SPT_ENTRIES - 1))
+
+/* spt에서 VA의 페이지를 담는 칸의 주소를 반환한다.
+ * 중간 테이블이 없으면 CREATE일 때 만들고, 아니거나 메모리가 없으면 NULL을 반환한다. */
+static struct page **spt_slot(struct supplemental_page_table *spt, const void *va, bool create)
+{
+	void **slot = &spt->spt_root;
+	for (int level = 0; level < SPT_LEVELS; level++) {
+		if (*slot == NULL) {
+			if (!create)
+				return NULL;
+			*slot = palloc_get_page(PAL_ZERO);
+			if (*slot == NULL)
+				return NULL;
+			if (++spt_table_cnt > spt_table_max)
+				spt_table_max = spt_table_cnt;
+		}
+		slot = (void **)*slot + spt_index(va, level);
+	}
+	return (struct page **)slot;
+}
+
 // spt에서 va로 페이지를 찾아 반환하는 함수
 struct page *spt_find_page(struct supplemental_page_table *spt, void *va)
 {
-	if (va == NULL || hash_empty(&spt->spt_hash))
+	if (va == NULL)
 		return NULL;
+	spt_lookup_cnt++;
 
-	// 1. 페이지 경계로 va를 내린다
-	struct page dummy_page;
-	dummy_page.va = pg_round_down(va);
+	struct page **slot = spt_slot(spt, va, false);
+	return slot != NULL ? *slot : NULL;
+}
 
-	// 2. 해시 테이블에서 검색한다.
-	struct hash_elem *find_elem = hash_find(&spt->spt_hash, &dummy_page.spt_hash_elem);
+/* spt에서 VA의 페이지를 찾고, 없지만 VA를 포함하는 영역이 있으면 그 자리에 페이지를 만들어 반환한다.
+ * SPT는 현재 스레드의 것이어야 한다. */
+static struct page *spt_lookup_page(struct supplemental_page_table *spt, void *va)
+{
+	struct page *page = spt_find_page(spt, va);
+	if (page != NULL)
+		return page;
 
-	// 3. 찾았으면 page구조체를 반환한다.
-	if (find_elem == NULL)
+	struct vma *vma = vma_find(spt, va);
+	if (vma == NULL || !vma_populate(vma, va))
 		return NULL;
-
-	return hash_entry(find_elem, struct page, spt_hash_elem);
+	return spt_find_page(spt, va);
 }
 
 // spt에 페이지 추가
@@ -119,65 +412,1079 @@ bool spt_insert_page(struct supplemental_page_table *spt, struct page *page)
 {
 	if (spt == NULL || page == NULL)
 		return false;
-	return hash_insert(&spt->spt_hash, &page->spt_hash_elem) == NULL;
+
+	struct page **slot = spt_slot(spt, page->va, true);
+	if (slot == NULL || *slot != NULL)
+		return false;
+	*slot = page;
+	spt->page_cnt++;
+	return true;
 }
 
 void spt_remove_page(struct supplemental_page_table *spt, struct page *page)
 {
 	if (spt == NULL || page == NULL)
-		return false;
-	hash_delete(&spt->spt_hash, &page->spt_hash_elem);
+		return;
+	willneed_cancel(spt);
+
+	struct page **slot = spt_slot(spt, page->va, false);
+	if (slot != NULL && *slot == page) {
+		*slot = NULL;
+		spt->page_cnt--;
+	}
 	vm_dealloc_page(page);
 }
 
-/* Get the struct frame, that will be evicted. */
+/* LEVEL 단계 테이블 TABLE(BASE부터의 주소를 담당)에서 [START, END) 안의 페이지에
+ * 주소 순으로 ACTION을 호출한다. 비어 있는 하위 테이블은 건너뛴다. */
+static void spt_walk(void **table, int level, uint64_t base, uint64_t start, uint64_t end,
+					 spt_action_func *action, void *aux)
+{
+	uint64_t span = 1ULL << spt_shift[level];
+	for (size_t i = 0; i < SPT_ENTRIES; i++) {
+		uint64_t lo = base + i * span;
+		if (lo >= end)
+			break;
+		if (lo + span <= start || table[i] == NULL)
+			continue;
+
+		if (level == SPT_LEVELS - 1)
+			action(table[i], aux);
+		else
+			spt_walk(table[i], level + 1, lo, start, end, action, aux);
+	}
+}
+
+/* spt에서 [START, END) 안의 페이지마다 주소 순으로 ACTION(page, AUX)을 호출한다.
+ * ACTION은 넘겨받은 페이지를 spt에서 지워도 된다. */
+void spt_for_each(struct supplemental_page_table *spt, void *start, void *end,
+				  spt_action_func *action, void *aux)
+{
+	if (spt->spt_root != NULL)
+		spt_walk(spt->spt_root, 0, 0, (uint64_t)start, (uint64_t)end, action, aux);
+}
+
+/* LEVEL 단계 테이블 TABLE과 그 아래의 테이블을 모두 해제한다. 페이지는 따로 정리해야 한다. */
+static void spt_free_table(void **table, int level)
+{
+	if (level < SPT_LEVELS - 1) {
+		for (size_t i = 0; i < SPT_ENTRIES; i++)
+			if (table[i] != NULL)
+				spt_free_table(table[i], level + 1);
+	}
+	palloc_free_page(table);
+	spt_table_cnt--;
+}
+
+/* Get the struct frame, that will be evicted.
+ * clock(second-chance) 알고리즘으로 희생 프레임을 고른다.
+ * 할당량을 넘긴 프로세스가 있으면 첫 바퀴에서는 그 프로세스들의 프레임만 본다.
+ * 다음 바퀴에서는 accessed 비트를 지우면서 쓰기 없이 버릴 수 있는 프레임을 찾고,
+ * 마지막 바퀴에서는 dirty 여부와 상관없이 accessed 비트가 꺼진 프레임을 고른다.
+ * pin된 프레임과 다른 스레드가 락을 잡고 있는 프레임은 건너뛴다.
+ * frame_table_lock을 잡은 상태에서 호출해야 하며, 고른 프레임의 락을 잡아서 반환한다. */
 static struct frame *vm_get_victim(void)
 {
-	struct frame *victim = list_entry(list_pop_front(&frame_list), struct frame, frame_elem);
-	return victim;
+	ASSERT(lock_held_by_current_thread(&frame_table_lock));
+
+	for (size_t i = ws_over_quota ? 0 : frame_cnt; i < 3 * frame_cnt; i++) {
+		struct frame *frame = clock_advance();
+		if (frame->page == NULL || frame->pin_cnt > 0)
+			continue;
+
+		// 할당량 안에 있는 프로세스의 프레임은 accessed 비트도 건드리지 않고 넘어간다
+		if (i < frame_cnt && !frame_over_quota(frame))
+			continue;
+
+		// 공유자 중 누구라도 최근에 접근했다면 한 번 더 기회를 준다
+		if (frame_is_accessed(frame)) {
+			frame->age = 0;
+			continue;
+		}
+		if (frame->age < UINT8_MAX)
+			frame->age++;
+
+		// 할당량 바퀴 다음 바퀴에서는 writeback이 필요한 페이지를 건너뛴다
+		if (i >= frame_cnt && i < 2 * frame_cnt && frame_needs_writeback(frame))
+			continue;
+
+		if (frame_try_lock(frame))
+			return frame;
+	}
+
+	// 두 바퀴 동안 모든 페이지가 다시 접근되었다면 바늘 위치부터 교체 가능한 프레임을 고른다
+	for (size_t i = 0; i < frame_cnt; i++) {
+		struct frame *frame = clock_advance();
+		if (frame->page != NULL && frame->pin_cnt == 0 && frame_try_lock(frame))
+			return frame;
+	}
+	return NULL;
+}
+
+/* FRAME의 락을 기다리지 않고 잡는다. 다른 스레드가 내용을 채우거나 쓰는 중이라면 false.
+ * frame_table_lock을 잡은 채로 프레임 락을 얻을 때는 이 함수만 쓴다. */
+static bool frame_try_lock(struct frame *frame)
+{
+	return !lock_held_by_current_thread(&frame->lock) && lock_try_acquire(&frame->lock);
 }
 
 /* Evict one page and return the corresponding frame.
- * Return NULL on error.*/
+ * Return NULL on error.
+ * swap에 자리가 없어 내보내지 못한 프레임은 그대로 두고 다른 희생 프레임을 고른다.
+ * 모든 프레임이 그렇다면 NULL을 반환한다.
+ * 반환된 프레임은 pin된 상태이며 이전 내용이 남아 있다. */
 static struct frame *vm_evict_frame(void)
 {
-	lock_acquire(&frame_table_lock);
-	struct frame *victim = vm_get_victim();
+	for (size_t i = 0; i < frame_cnt; i++) {
+		lock_acquire(&frame_table_lock);
+		struct frame *victim = vm_get_victim();
+		if (victim == NULL) {
+			lock_release(&frame_table_lock);
+			return NULL;
+		}
+		if (frame_evict(victim))
+			return victim;
+	}
+	return NULL;
+}
+
+/* vm_get_victim()이 고른 VICTIM의 내용을 내보내고 페이지들을 떼어 낸다.
+ * 프레임을 공유하는 모든 페이지(page_list)의 매핑을 먼저 끊고 내용을 한 번만 내보낸다.
+ * 디스크 I/O는 frame_table_lock 없이 희생 프레임의 락만 잡고 하므로 다른 페이지의 fault는
+ * 기다리지 않고, 이 프레임의 페이지에 난 fault만 vm_frame_lock()에서 끝나기를 기다린다.
+ * swap_out()이 실패하면 페이지들을 프레임에 붙여 둔 채 false를 반환한다. 매핑은 다음 접근 때
+ * vm_map_resident()가 되살린다. frame_table_lock과 VICTIM의 락을 잡고 호출하며 둘 다 놓는다.
+ * true를 반환하면 VICTIM은 pin된 채로 남는다. */
+static bool frame_evict(struct frame *victim)
+{
 	struct page *page = victim->page;
 
-	swap_out(page);
+	victim->pin_cnt++;
+	text_cache_remove(victim);
+	// 매핑을 지우면 dirty 비트도 사라지므로 그 전에 dirty_hint로 모아 둔다
+	bool clean = !frame_needs_writeback(victim);
+
+	// 내보내는 동안 다른 공유자가 내용을 바꾸지 못하도록 모든 매핑을 먼저 끊는다
+	struct list_elem *e;
+	for (e = list_begin(&victim->page_list); e != list_end(&victim->page_list); e = list_next(e)) {
+		struct page *p = list_entry(e, struct page, frame_elem);
+		pml4_clear_page(p->owner_thread->pml4, p->va);
+	}
+	lock_release(&frame_table_lock);
+
+	// fault-around로 읽어 두기만 한 uninit 페이지는 다시 파일에서 읽으면 된다
+	if (VM_TYPE(page->operations->type) != VM_UNINIT && !swap_out(page)) {
+		// 내용을 둘 곳이 없다. 프레임을 내주면 내용을 잃으므로 그대로 둔다
+		lock_acquire(&frame_table_lock);
+		victim->pin_cnt--;
+		swap_fail_cnt++;
+		lock_release(&frame_table_lock);
+		lock_release(&victim->lock);
+		return false;
+	}
+
+	// 나머지 공유자들은 같은 swap 슬롯을 가리키게 한다. 파일 페이지는 대표만 쓰면 된다.
+	// 프레임 락을 잡고 있으므로 그동안 page_list는 바뀌지 않는다
+	for (e = list_begin(&victim->page_list); e != list_end(&victim->page_list); e = list_next(e)) {
+		struct page *p = list_entry(e, struct page, frame_elem);
+		if (p != page && VM_TYPE(p->operations->type) == VM_ANON)
+			anon_swap_share(p, page);
+		else if (p != page && VM_TYPE(p->operations->type) != VM_UNINIT)
+			swap_out(p);
+	}
+
+	lock_acquire(&frame_table_lock);
+	evict_cnt++;
+	if (clean)
+		evict_clean_cnt++;
+	while (!list_empty(&victim->page_list))
+		frame_detach(victim, list_entry(list_front(&victim->page_list), struct page, frame_elem));
+	victim->dirty_hint = false;
+	victim->referenced = false;
+	victim->age = 0;
+	lock_release(&frame_table_lock);
+	lock_release(&victim->lock);
+	return true;
+}
+
+/* 시계 바늘이 가리키는 프레임을 반환하고 바늘을 한 칸 전진시킨다.
+ * 배열의 끝에 도달하면 처음으로 돌아간다. */
+static struct frame *clock_advance(void)
+{
+	struct frame *frame = &frame_table[clock_hand];
+	clock_hand = (clock_hand + 1) % frame_cnt;
+	return frame;
+}
+
+/* 프레임을 내보낼 때 디스크 쓰기가 필요한지 판단한다.
+ * 파일 페이지와 스왑 캐시에 슬롯이 남은 anon 페이지는 수정되지 않았다면 버려도 되지만,
+ * 그 밖의 anon 페이지는 항상 swap 디스크에 써야 한다.
+ * 한 번 dirty로 확인된 프레임은 dirty_hint로 기억해 둔다. */
+static bool frame_needs_writeback(struct frame *frame)
+{
+	struct page *page = frame->page;
+	// readahead나 fault-around로 읽어 두기만 한 페이지는 디스크에 같은 내용이 있다
+	if (VM_TYPE(page->operations->type) == VM_ANON && page->anon.readahead)
+		return false;
+	if (VM_TYPE(page->operations->type) == VM_UNINIT)
+		return false;
+	if (VM_TYPE(page->operations->type) == VM_ANON && page->anon.swap_table_index != BITMAP_ERROR)
+		return frame_is_dirty(frame);
+	if (VM_TYPE(page->operations->type) != VM_FILE)
+		return true;
+	return frame_is_dirty(frame);
+}
+
+/* FRAME을 공유하는 페이지 중 하나라도 accessed 비트가 켜져 있으면 true.
+ * working set 샘플러가 거둬 간 접근 기록(referenced)도 본다.
+ * 다음 바퀴를 위해 모든 매핑의 accessed 비트를 지운다. frame_table_lock을 잡고 호출한다. */
+static bool frame_is_accessed(struct frame *frame)
+{
+	bool accessed = frame->referenced;
+	struct list_elem *e;
+
+	frame->referenced = false;
+	for (e = list_begin(&frame->page_list); e != list_end(&frame->page_list); e = list_next(e)) {
+		struct page *page = list_entry(e, struct page, frame_elem);
+		if (page_harvest_accessed(page) > 0)
+			accessed = true;
+	}
+	return accessed;
+}
+
+/* PAGE 매핑의 accessed 비트를 읽고 지운다. 꺼져 있었다면 0, 켜져 있었다면 접근된 것으로 칠
+ * 4KB 페이지 수를 반환한다. 2MB 매핑의 512개 프레임은 PDE의 accessed 비트 하나를 나눠 쓰므로,
+ * 처음 본 프레임만 비트를 가져가면 나머지는 접근되지 않은 것처럼 보여 먼저 교체된다.
+ * 그래서 비트를 같은 매핑의 다른 프레임들의 referenced에 옮겨 두고 HUGE_PGCNT를 반환한다.
+ * frame_table_lock을 잡고 호출한다. */
+static size_t page_harvest_accessed(struct page *page)
+{
+	uint64_t *pml4 = page->owner_thread->pml4;
+	if (!pml4_is_accessed(pml4, page->va))
+		return 0;
+	pml4_set_accessed(pml4, page->va, false);
+	if (!pml4_is_huge(pml4, page->va))
+		return 1;
+
+	// 2MB 매핑은 가상 주소와 프레임이 같은 순서로 이어져 있다
+	size_t first = (page->frame - frame_table) - pg_no(page->va) % HUGE_PGCNT;
+	for (size_t i = first; i < first + HUGE_PGCNT; i++)
+		if (&frame_table[i] != page->frame)
+			frame_table[i].referenced = true;
+	return HUGE_PGCNT;
+}
+
+/* FRAME의 대표 페이지를 가진 프로세스가 프레임 할당량을 넘겼으면 true. */
+static bool frame_over_quota(struct frame *frame)
+{
+	struct supplemental_page_table *spt = &frame->page->owner_thread->spt;
+	return spt->rss > spt->frame_quota;
+}
+
+/* FRAME을 공유하는 페이지 중 하나라도 dirty 비트가 켜져 있으면 dirty_hint에 기억하고 true.
+ * frame_table_lock을 잡고 호출한다. */
+static bool frame_is_dirty(struct frame *frame)
+{
+	struct list_elem *e;
+
+	for (e = list_begin(&frame->page_list); e != list_end(&frame->page_list) && !frame->dirty_hint;
+		 e = list_next(e)) {
+		struct page *page = list_entry(e, struct page, frame_elem);
+		if (pml4_is_dirty(page->owner_thread->pml4, page->va))
+			frame->dirty_hint = true;
+	}
+	return frame->dirty_hint;
+}
+
+/* FRAME의 모든 매핑과 dirty_hint에서 dirty 표시를 지운다. frame_table_lock을 잡고 호출한다. */
+static void frame_clear_dirty(struct frame *frame)
+{
+	struct list_elem *e;
+
+	for (e = list_begin(&frame->page_list); e != list_end(&frame->page_list); e = list_next(e)) {
+		struct page *page = list_entry(e, struct page, frame_elem);
+		pml4_set_dirty(page->owner_thread->pml4, page->va, false);
+	}
+	frame->dirty_hint = false;
+}
+
+/* 커널 가상 주소 KVA에 해당하는 프레임을 반환한다.
+ * KVA는 유저 풀에서 할당된 페이지여야 한다. */
+struct frame *vm_frame_lookup(void *kva)
+{
+	ASSERT(pg_ofs(kva) == 0);
+
+	size_t idx = pg_no(kva) - pg_no(frame_base);
+	ASSERT(idx < frame_cnt);
+	return &frame_table[idx];
+}
+
+/* PAGE를 FRAME에 연결한다. 프레임을 공유하는 페이지는 page_list에 모두 모인다.
+ * frame->page는 그 중 대표 페이지를 가리킨다. 프레임 락과 frame_table_lock을 잡고 호출한다. */
+static void frame_attach(struct frame *frame, struct page *page)
+{
+	ASSERT(lock_held_by_current_thread(&frame_table_lock));
+	ASSERT(lock_held_by_current_thread(&frame->lock));
+
+	list_push_back(&frame->page_list, &page->frame_elem);
+	frame->ref_cnt++;
+	page->owner_thread->spt.rss++;
+	if (frame->page == NULL)
+		frame->page = page;
+	page->frame = frame;
+}
 
-	pml4_clear_page(page->owner_thread->pml4, page->va);
+/* PAGE와 FRAME의 연결을 끊는다. 대표 페이지가 떠나면 남은 공유자 중 하나로 바꾼다.
+ * 프레임 락과 frame_table_lock을 잡고 호출한다. */
+static void frame_detach(struct frame *frame, struct page *page)
+{
+	ASSERT(lock_held_by_current_thread(&frame_table_lock));
+	ASSERT(lock_held_by_current_thread(&frame->lock));
+	ASSERT(frame->ref_cnt > 0);
+
+	list_remove(&page->frame_elem);
+	frame->ref_cnt--;
+	page->owner_thread->spt.rss--;
+	if (frame->page == page)
+		frame->page = list_empty(&frame->page_list)
+						  ? NULL
+						  : list_entry(list_front(&frame->page_list), struct page, frame_elem);
 	page->frame = NULL;
-	victim->page = NULL;
+}
+
+/* 더 이상 쓰이지 않는 프레임의 상태를 초기화한다. 물리 메모리는 호출자가 반납한다. */
+static void frame_reset(struct frame *frame)
+{
+	ASSERT(frame->ref_cnt == 0);
+
+	frame->page = NULL;
+	frame->pin_cnt = 0;
+	frame->dirty_hint = false;
+	frame->referenced = false;
+	frame->age = 0;
+}
+
+/* frame_reset()한 프레임의 물리 메모리를 유저 풀에 반납한다. frame_table_lock 없이 호출한다. */
+static void frame_free(struct frame *frame)
+{
+	palloc_free_page(frame->kva);
+
+	lock_acquire(&frame_table_lock);
+	free_frame_cnt++;
+	lock_release(&frame_table_lock);
+}
+
+/* PAGE가 쓰던 프레임의 참조를 놓는다. 마지막 참조였다면 물리 메모리를 반납한다.
+ * 페이지의 destroy 경로에서 매핑을 지운 뒤 호출한다. 교체 중이라면 끝나기를 기다린다. */
+void vm_free_frame(struct page *page)
+{
+	struct frame *frame = vm_frame_lock(page);
+	if (frame == NULL)
+		return;
+
+	lock_acquire(&frame_table_lock);
+	if (frame->ref_cnt == 1)
+		text_cache_remove(frame);
+	frame_detach(frame, page);
+	bool last = frame->ref_cnt == 0;
+	if (last)
+		frame_reset(frame);
+	lock_release(&frame_table_lock);
+	vm_frame_unlock(frame);
+
+	if (last)
+		frame_free(frame);
+}
+
+/* PAGE가 붙어 있는 프레임의 락을 잡고 반환한다. 프레임이 없으면 NULL.
+ * 교체나 읽기가 진행 중이면 끝나기를 기다리며, 그 사이 페이지가 떨어져 나갔다면
+ * 다시 확인한다. 락을 잡고 있는 동안 PAGE는 그 프레임에서 떨어지지 않는다. */
+struct frame *vm_frame_lock(struct page *page)
+{
+	for (;;) {
+		struct frame *frame = page->frame;
+		if (frame == NULL)
+			return NULL;
+
+		lock_acquire(&frame->lock);
+		if (page->frame == frame)
+			return frame;
+		lock_release(&frame->lock);
+	}
+}
+
+/* vm_frame_lock()으로 잡은 FRAME의 락을 놓는다. */
+void vm_frame_unlock(struct frame *frame)
+{
+	lock_release(&frame->lock);
+}
+
+/* PAGE가 붙어 있는 프레임을 pin하고 반환한다. 프레임이 없으면 NULL.
+ * vm_frame_unpin()할 때까지 교체되지 않으므로 커널이 kva로 내용을 읽고 쓸 수 있다. */
+struct frame *vm_frame_pin(struct page *page)
+{
+	struct frame *frame = vm_frame_lock(page);
+	if (frame == NULL)
+		return NULL;
+
+	lock_acquire(&frame_table_lock);
+	frame->pin_cnt++;
+	lock_release(&frame_table_lock);
+	vm_frame_unlock(frame);
+	return frame;
+}
+
+/* FRAME의 pin을 하나 푼다. */
+void vm_frame_unpin(struct frame *frame)
+{
+	lock_acquire(&frame_table_lock);
+	ASSERT(frame->pin_cnt > 0);
+	frame->pin_cnt--;
+	lock_release(&frame_table_lock);
+}
+
+/* 현재 프로세스의 유저 주소 UADDR가 속한 페이지를 프레임에 올리고 pin한 뒤 그 프레임을 반환한다.
+ * 시스템 콜이 유저 버퍼를 kva로 직접 읽고 쓰는 동안 프레임이 교체되지 않게 하려고 쓴다.
+ * WRITE면 zero 프레임이나 공유 중인 프레임을 먼저 전용 프레임으로 바꾸고, kva로 쓴 내용이
+ * 교체나 writeback 때 빠지지 않도록 pte를 dirty로 표시한다. 읽기만 한다면 zero 프레임을
+ * 보는 페이지는 공유를 깨지 않고 zero_frame을 pin해서 반환한다.
+ * 페이지가 아직 없으면 (한 번도 접근하지 않은 영역) NULL이므로 먼저 접근해 fault를 내야 한다. */
+struct frame *vm_pin_user(const void *uaddr, bool write)
+{
+	struct page *page = spt_find_page(&thread_current()->spt, (void *)uaddr);
+	if (page == NULL || (write && !page->writable))
+		return NULL;
+
+	for (;;) {
+		if (!write && page->frame == NULL && VM_TYPE(page->operations->type) == VM_ANON
+			&& page->anon.zero) {
+			lock_acquire(&frame_table_lock);
+			zero_frame.pin_cnt++;
+			lock_release(&frame_table_lock);
+			return &zero_frame;
+		}
+
+		struct frame *frame = vm_frame_pin(page);
+		if (frame != NULL && (!write || frame->ref_cnt == 1)) {
+			if (write)
+				pml4_set_dirty(page->owner_thread->pml4, page->va, true);
+			return frame;
+		}
+
+		// 교체되었다면 다시 읽어 들이고, 쓰려는데 zero 프레임을 보거나 공유 중이라면 복사해서 떼어 낸다
+		bool success;
+		if (frame != NULL) {
+			vm_frame_unpin(frame);
+			success = vm_handle_wp(page);
+		} else if (VM_TYPE(page->operations->type) == VM_ANON && page->anon.zero)
+			success = vm_handle_wp(page);
+		else
+			success = vm_do_claim_page(page);
+		if (!success)
+			return NULL;
+	}
+}
+
+/* 공유 가능한 실행 파일 세그먼트 페이지라면 text cache의 키를 KEY에 채우고 true를 반환한다. */
+static bool text_cache_key(struct page *page, struct text_cache_entry *key)
+{
+	struct file *file;
+	off_t offset;
+	uint32_t read_bytes;
+
+	if (VM_TYPE(page->operations->type) == VM_UNINIT) {
+		struct mmap_aux *aux = page->uninit.aux;
+		if (VM_TYPE(page->uninit.type) != VM_FILE || !aux->shared)
+			return false;
+		file = aux->file;
+		offset = aux->offset;
+		read_bytes = aux->page_read_bytes;
+	} else {
+		if (VM_TYPE(page->operations->type) != VM_FILE || !page->file.shared)
+			return false;
+		file = page->file.file;
+		offset = page->file.offset;
+		read_bytes = page->file.page_read_bytes;
+	}
+
+	key->inode = file_get_inode(file);
+	key->offset = offset;
+	key->read_bytes = read_bytes;
+	return true;
+}
+
+/* KEY에 해당하는 프레임이 text cache에 있으면 PAGE를 그 프레임에 읽기 전용으로 매핑한다.
+ * 디스크에서 읽지 않고 매핑했다면 true를 반환한다. */
+static bool text_cache_map(struct page *page, struct text_cache_entry *key)
+{
+	lock_acquire(&frame_table_lock);
+	struct hash_elem *e = hash_find(&text_cache, &key->elem);
+	struct frame *frame = e != NULL ? hash_entry(e, struct text_cache_entry, elem)->frame : NULL;
+	// 다른 스레드가 그 프레임을 잡고 있으면 기다리지 않고 직접 읽는다
+	if (frame == NULL || !frame_try_lock(frame)) {
+		lock_release(&frame_table_lock);
+		return false;
+	}
+
+	// 공유 프레임도 교체될 수 있으므로 매핑까지 마친 뒤에 락을 놓는다.
+	// 처음 매핑되는 페이지라면 읽기 없이 파일 페이지로만 바꾼다
+	frame_attach(frame, page);
+	bool success = (VM_TYPE(page->operations->type) != VM_UNINIT
+					|| uninit_transmute(page, frame->kva))
+				   && pml4_set_page(page->owner_thread->pml4, page->va, frame->kva, false);
+	lock_release(&frame_table_lock);
+	lock_release(&frame->lock);
+
+	if (!success) {
+		vm_free_frame(page);
+		return false;
+	}
+
+	text_hit_cnt++;
+	return true;
+}
+
+/* 방금 읽어 들인 FRAME을 KEY로 text cache에 등록한다.
+ * 다른 프로세스가 먼저 등록했다면 FRAME은 공유하지 않고 그대로 둔다. */
+static void text_cache_insert(struct text_cache_entry *key, struct frame *frame)
+{
+	struct text_cache_entry *entry = malloc(sizeof(*entry));
+	if (entry == NULL)
+		return;
+
+	*entry = *key;
+	entry->frame = frame;
+
+	lock_acquire(&frame_table_lock);
+	bool inserted = hash_insert(&text_cache, &entry->elem) == NULL;
 	lock_release(&frame_table_lock);
-	return victim;
+
+	if (!inserted)
+		free(entry);
+}
+
+/* FRAME이 text cache에 등록되어 있으면 뺀다. 프레임의 마지막 매핑이 사라질 때
+ * (교체 또는 해제) frame_table_lock을 잡은 상태에서 호출한다. */
+static void text_cache_remove(struct frame *frame)
+{
+	ASSERT(lock_held_by_current_thread(&frame_table_lock));
+
+	struct text_cache_entry key;
+	if (frame->page == NULL || !text_cache_key(frame->page, &key))
+		return;
+
+	struct hash_elem *e = hash_find(&text_cache, &key.elem);
+	if (e == NULL)
+		return;
+
+	struct text_cache_entry *entry = hash_entry(e, struct text_cache_entry, elem);
+	if (entry->frame != frame)
+		return;
+
+	hash_delete(&text_cache, e);
+	free(entry);
+}
+
+static uint64_t text_cache_hash_func(const struct hash_elem *elem, void *aux UNUSED)
+{
+	struct text_cache_entry *entry = hash_entry(elem, struct text_cache_entry, elem);
+	uint64_t hash = hash_bytes(&entry->inode, sizeof(entry->inode));
+	hash ^= hash_int(entry->offset);
+	return hash ^ hash_int(entry->read_bytes);
+}
+
+static bool text_cache_less_func(const struct hash_elem *elem_a, const struct hash_elem *elem_b,
+								 void *aux UNUSED)
+{
+	struct text_cache_entry *a = hash_entry(elem_a, struct text_cache_entry, elem);
+	struct text_cache_entry *b = hash_entry(elem_b, struct text_cache_entry, elem);
+	if (a->inode != b->inode)
+		return a->inode < b->inode;
+	if (a->offset != b->offset)
+		return a->offset < b->offset;
+	return a->read_bytes < b->read_bytes;
 }
 
 /* palloc()으로 프레임을 획득한다. 사용가능한 페이지가 없으면 페이지를 제거한다.
  * 이 함수는 항상 유효한 주소를 반환한다. 즉, 유저풀 메모리가 가득 차있으면
- * 메모리 공간을 확보하기 위해 프레임을 제거한다. */
-static struct frame *vm_get_frame(void)
+ * 메모리 공간을 확보하기 위해 프레임을 제거한다.
+ * 반환된 프레임은 내용이 채워질 때까지 교체되지 않도록 pin되어 있다.
+ * ZERO가 false면 내용을 0으로 채우지 않는다. 호출자가 프레임 전체를 덮어쓸 때 쓴다. */
+static struct frame *vm_get_frame(bool zero)
 {
+	struct frame *frame = frame_alloc(zero ? PAL_ZERO : 0);
+	if (frame == NULL) {
+		// 데몬이 따라잡지 못했다. 직접 교체하고 데몬도 깨운다
+		lock_acquire(&frame_table_lock);
+		sync_evict_cnt++;
+		pageout_wakeup();
+		lock_release(&frame_table_lock);
+
+		struct frame *victim = vm_evict_frame();
+		if (victim == NULL)
+			PANIC("vm_get_frame: no evictable frame (swap full?)");
+
+		// palloc_get_page(PAL_ZERO)와 같은 상태로 돌려준다
+		if (zero)
+			memset(victim->kva, 0, PGSIZE);
+		return victim;
+	}
+	return frame;
+}
 
-	void *kva = palloc_get_page(PAL_USER | PAL_ZERO);
+/* 유저 풀에서 빈 프레임을 pin된 상태로 가져온다. 남은 프레임이 없으면 교체하지 않고 NULL을 반환한다.
+ * FLAGS에는 PAL_ZERO 등을 줄 수 있다. */
+static struct frame *frame_alloc(enum palloc_flags flags)
+{
+	void *kva = palloc_get_page(PAL_USER | flags);
 	if (kva == NULL)
-		return vm_evict_frame();
+		return NULL;
 
-	// frame 구조체를 생성한다
-	struct frame *frame = malloc(sizeof(*frame));
-	if (frame == NULL)
-		PANIC("(vm_get_frame)");
+	struct frame *frame = vm_frame_lookup(kva);
 
-	*frame = (struct frame){
-		.page = NULL,
-		.kva = kva,
-	};
+	lock_acquire(&frame_table_lock);
+	ASSERT(frame->page == NULL && frame->ref_cnt == 0);
+	frame->pin_cnt = 1;
+	free_frame_cnt--;
+	if (free_frame_cnt < vm_pageout_low)
+		pageout_wakeup();
+	lock_release(&frame_table_lock);
 
-	ASSERT(frame->page == NULL);
 	return frame;
 }
 
+/* 새로 얻은 FRAME에 PAGE를 붙인다. 프레임을 구하는 사이 pageout 데몬이 MADV_WILLNEED로
+ * PAGE를 먼저 읽어 들였다면 붙이지 않고 false를 반환한다. FRAME의 락을 잡고 호출한다. */
+static bool frame_attach_new(struct frame *frame, struct page *page)
+{
+	lock_acquire(&frame_table_lock);
+	bool attach = page->frame == NULL;
+	if (attach)
+		frame_attach(frame, page);
+	lock_release(&frame_table_lock);
+	return attach;
+}
+
+/* 페이지를 붙이지 못한 새 FRAME의 락을 놓고 유저 풀에 돌려준다. */
+static void frame_discard(struct frame *frame)
+{
+	lock_acquire(&frame_table_lock);
+	frame_reset(frame);
+	lock_release(&frame_table_lock);
+	lock_release(&frame->lock);
+	frame_free(frame);
+}
+
+/* pageout 데몬이 자고 있으면 깨운다. frame_table_lock을 잡은 상태에서 호출한다. */
+static void pageout_wakeup(void)
+{
+	ASSERT(lock_held_by_current_thread(&frame_table_lock));
+
+	if (pageout_running)
+		return;
+	pageout_running = true;
+	sema_up(&pageout_sema);
+}
+
+/* pageout 데몬 스레드. 깨어날 때마다 여유 프레임을 vm_pageout_high개까지 회수하고,
+ * madvise(MADV_WILLNEED)로 맡겨진 요청이 있으면 하나씩 처리하며 그때마다 다시 회수한다.
+ * 남은 요청이 없을 때만 잠든다. */
+static void pageout_daemon(void *aux UNUSED)
+{
+	for (;;) {
+		sema_down(&pageout_sema);
+		pageout_wake_cnt++;
+
+		for (;;) {
+			pageout_reclaim();
+			struct willneed_req *req = willneed_next();
+			if (req == NULL)
+				break;
+			willneed_run(req);
+			willneed_finish(req);
+		}
+	}
+}
+
+/* 여유 프레임이 vm_pageout_high개가 될 때까지 clock으로 고른 희생 프레임을 내보내고
+ * 유저 풀에 반납한다. pageout 데몬이 부른다. */
+static void pageout_reclaim(void)
+{
+	// 이번에 내보내는 anon 페이지들은 swap 클러스터 단위로 모아 쓴다
+	anon_swap_batch_begin();
+	for (;;) {
+		lock_acquire(&frame_table_lock);
+		bool enough = free_frame_cnt >= vm_pageout_high;
+		lock_release(&frame_table_lock);
+		if (enough)
+			break;
+
+		// 교체할 수 있는 프레임이 없다면 다음에 깨울 때 다시 시도한다
+		struct frame *victim = vm_evict_frame();
+		if (victim == NULL)
+			break;
+
+		lock_acquire(&frame_table_lock);
+		frame_reset(victim);
+		lock_release(&frame_table_lock);
+		frame_free(victim);
+		pageout_cnt++;
+	}
+	anon_swap_batch_end();
+}
+
+/* 다음에 처리할 MADV_WILLNEED 요청을 꺼내 willneed_cur로 삼는다. 남은 요청이 없으면
+ * 데몬이 잠든다고 표시하고 NULL을 반환한다. 같은 락 안에서 확인하므로 그 사이 들어온 요청은
+ * pageout_wakeup()이 데몬을 다시 깨운다. */
+static struct willneed_req *willneed_next(void)
+{
+	struct willneed_req *req = NULL;
+
+	lock_acquire(&frame_table_lock);
+	if (list_empty(&willneed_queue))
+		pageout_running = false;
+	else {
+		req = list_entry(list_pop_front(&willneed_queue), struct willneed_req, elem);
+		willneed_cur = req;
+	}
+	lock_release(&frame_table_lock);
+	return req;
+}
+
+/* REQ의 페이지들을 차례로 프레임에 읽어 둔다. 프레임은 매핑하지 않고 붙여만 둔다.
+ * 교체를 일으키지 않도록 워터마크 위의 여유 프레임만 쓰고, 모자라면 나머지는 버린다.
+ * 그 사이 프로세스가 직접 읽어 들였거나 더 읽을 필요가 없어진 페이지는 건너뛴다. */
+static void willneed_run(struct willneed_req *req)
+{
+	for (size_t i = 0; i < req->cnt; i++) {
+		struct page *page = req->pages[i];
+
+		if (free_frame_cnt <= vm_pageout_low)
+			break;
+		struct frame *frame = frame_alloc(0);
+		if (frame == NULL)
+			break;
+
+		lock_acquire(&frame->lock);
+		lock_acquire(&frame_table_lock);
+		struct file_extent ext;
+		bool from_file = file_extent_of(page, &ext);
+		bool wanted = page->frame == NULL && page_needs_read(page);
+		if (wanted)
+			frame_attach(frame, page);
+		lock_release(&frame_table_lock);
+		if (!wanted) {
+			frame_discard(frame);
+			continue;
+		}
+
+		// 파일 페이지는 fault-around처럼 uninit 상태로 내용만 채워 둔다
+		bool read = true;
+		if (from_file)
+			file_extent_filled(page, frame->kva,
+							   file_read_at(ext.file, frame->kva, ext.read_bytes, ext.offset));
+		else
+			read = anon_swap_readahead(page, frame->kva);
+		lock_release(&frame->lock);
+		if (!read) {
+			vm_free_frame(page);
+			continue;
+		}
+		vm_frame_unpin(frame);
+		willneed_read_cnt++;
+	}
+}
+
+/* 처리를 마친 REQ를 해제하고 willneed_cancel()에서 기다리는 프로세스를 깨운다. */
+static void willneed_finish(struct willneed_req *req)
+{
+	lock_acquire(&frame_table_lock);
+	willneed_cur = NULL;
+	req->spt->willneed_cnt--;
+	cond_broadcast(&willneed_done, &frame_table_lock);
+	lock_release(&frame_table_lock);
+	free(req);
+}
+
+/* SPT가 맡겨 둔 MADV_WILLNEED 요청을 버리고, 데몬이 그 요청을 처리 중이면 끝나기를 기다린다.
+ * 데몬이 요청에 담긴 페이지를 건드리지 않게 하려고 spt에서 페이지를 지우기 전에 부른다.
+ * willneed_cnt는 데몬이 요청을 끝낸 뒤에만 줄어들므로 0이면 락 없이 돌아가도 된다. */
+static void willneed_cancel(struct supplemental_page_table *spt)
+{
+	if (spt->willneed_cnt == 0)
+		return;
+
+	lock_acquire(&frame_table_lock);
+	struct list_elem *e = list_begin(&willneed_queue);
+	while (e != list_end(&willneed_queue)) {
+		struct willneed_req *req = list_entry(e, struct willneed_req, elem);
+		e = list_next(e);
+		if (req->spt == spt) {
+			list_remove(&req->elem);
+			spt->willneed_cnt--;
+			free(req);
+		}
+	}
+	while (willneed_cur != NULL && willneed_cur->spt == spt)
+		cond_wait(&willneed_done, &frame_table_lock);
+	lock_release(&frame_table_lock);
+}
+
+/* FRAME에 붙은 PAGE가 파일에 다시 써야 하는 mmap 페이지인지 판단한다. frame_table_lock을 잡고 호출한다. */
+static bool page_needs_writeback(struct frame *frame, struct page *page)
+{
+	if (VM_TYPE(page->operations->type) != VM_FILE || page->file.shared)
+		return false;
+	return frame_is_dirty(frame);
+}
+
+/* ENTRIES[0..CNT)를 순서대로 파일에 쓴다. 같은 inode에서 오프셋이 이어지는 페이지는
+ * WB_BATCH개까지 writeback_buf에 모아 한 번에 쓴다.
+ * dirty 비트를 먼저 지우고 내용을 복사하므로, 그 뒤의 쓰기는 다음 writeback에서 다시 잡힌다.
+ * 묶음에 넣은 프레임들의 락을 쓰기가 끝날 때까지 잡고 있으므로 그동안 페이지가 사라지지 않는다.
+ * 다른 프레임 락을 잡고 있을 때는 기다리지 않고, 바쁜 프레임을 만나면 묶음을 거기서 끊는다. */
+static void writeback_entries(struct writeback_entry *entries, size_t cnt)
+{
+	static struct frame *locked[WB_BATCH]; /* writeback_buf에 담은 페이지의 프레임 */
+
+	lock_acquire(&writeback_lock);
+
+	size_t i = 0;
+	while (i < cnt) {
+		struct file *file = NULL;
+		off_t offset = 0;
+		size_t length = 0, n = 0;
+
+		for (; i < cnt && n < WB_BATCH; i++) {
+			struct writeback_entry *e = &entries[i];
+			struct page *page = e->page;
+			if (n == 0)
+				lock_acquire(&e->frame->lock);
+			else if (!frame_try_lock(e->frame))
+				break;
+
+			lock_acquire(&frame_table_lock);
+			bool dirty = e->frame->page == page && page_needs_writeback(e->frame, page);
+			struct file_page *file_page = &page->file;
+			bool adjacent = dirty
+							&& (n == 0
+								|| (file_get_inode(file_page->file) == file_get_inode(file)
+									&& file_page->offset == offset + length));
+			if (adjacent)
+				frame_clear_dirty(e->frame);
+			lock_release(&frame_table_lock);
+
+			if (!adjacent) {
+				lock_release(&e->frame->lock);
+				if (dirty)
+					break;
+				continue;
+			}
+
+			if (n == 0) {
+				file = file_page->file;
+				offset = file_page->offset;
+			}
+			locked[n++] = e->frame;
+			memcpy(writeback_buf + length, e->frame->kva, file_page->page_read_bytes);
+			length += file_page->page_read_bytes;
+
+			// 파일 끝의 짧은 페이지 뒤로는 이어 쓸 수 없다
+			if (file_page->page_read_bytes < PGSIZE) {
+				i++;
+				break;
+			}
+		}
+
+		if (n > 0) {
+			off_t result = file_write_at(file, writeback_buf, length, offset);
+			if (result != (off_t)length)
+				printf("File write failed! intended: %zu, actual: %d", length, result);
+			writeback_cnt += n;
+			writeback_io_cnt++;
+		}
+		while (n > 0)
+			lock_release(&locked[--n]->lock);
+	}
+	lock_release(&writeback_lock);
+}
+
+struct writeback_batch {
+	struct writeback_entry entries[WB_BATCH];
+	size_t cnt;
+};
+
+static void writeback_collect(struct page *page, void *batch_)
+{
+	struct writeback_batch *batch = batch_;
+	struct frame *frame = page->frame;
+	if (frame == NULL || VM_TYPE(page->operations->type) != VM_FILE || page->file.shared)
+		return;
+
+	batch->entries[batch->cnt++] = (struct writeback_entry){.frame = frame, .page = page};
+	if (batch->cnt == WB_BATCH) {
+		writeback_entries(batch->entries, batch->cnt);
+		batch->cnt = 0;
+	}
+}
+
+/* 현재 프로세스의 [START, END) 안의 dirty한 mmap 페이지를 지금 파일에 쓴다 (msync, munmap).
+ * 주소 순으로 돌기 때문에 한 영역 안의 페이지는 파일 오프셋 순서이기도 하다. */
+void vm_writeback_range(void *start, void *end)
+{
+	struct writeback_batch batch;
+	batch.cnt = 0;
+	spt_for_each(&thread_current()->spt, start, end, writeback_collect, &batch);
+	writeback_entries(batch.entries, batch.cnt);
+}
+
+/* flusher에게 다음 확인 때 바로 writeback하도록 요청한다 (msync의 MS_ASYNC). */
+void vm_writeback_async(void)
+{
+	writeback_requested = true;
+}
+
+static int writeback_entry_cmp(const void *a_, const void *b_)
+{
+	const struct writeback_entry *a = a_, *b = b_;
+	if (a->inode != b->inode)
+		return a->inode < b->inode ? -1 : 1;
+	return a->offset < b->offset ? -1 : a->offset > b->offset;
+}
+
+/* flusher 스레드. WB_INTERVAL마다 (또는 MS_ASYNC 요청이 있으면 바로) 프레임 테이블을 훑어
+ * dirty한 mmap 페이지를 모으고, 파일과 오프셋 순으로 정렬해 이어지는 구간끼리 묶어 쓴다.
+ * 그래서 munmap이나 종료 시점에 남는 dirty 페이지가 많지 않다. */
+static void flusher_daemon(void *aux UNUSED)
+{
+	struct writeback_entry *entries = palloc_get_page(PAL_ASSERT);
+	const size_t capacity = PGSIZE / sizeof(*entries);
+	int64_t last = timer_ticks();
+
+	for (;;) {
+		timer_sleep(WB_POLL);
+		if (!writeback_requested && timer_elapsed(last) < WB_INTERVAL)
+			continue;
+		writeback_requested = false;
+		last = timer_ticks();
+
+		size_t cnt = 0;
+		lock_acquire(&frame_table_lock);
+		for (size_t n = 0; n < frame_cnt && cnt < capacity; n++) {
+			struct frame *frame = &frame_table[flush_hand];
+			struct page *page = frame->page;
+			flush_hand = (flush_hand + 1) % frame_cnt;
+			if (page == NULL || frame->pin_cnt > 0 || !page_needs_writeback(frame, page))
+				continue;
+
+			entries[cnt++] = (struct writeback_entry){
+				.frame = frame,
+				.page = page,
+				.inode = file_get_inode(page->file.file),
+				.offset = page->file.offset,
+			};
+		}
+		lock_release(&frame_table_lock);
+
+		qsort(entries, cnt, sizeof(*entries), writeback_entry_cmp);
+		writeback_entries(entries, cnt);
+	}
+}
+
+/* 할당량을 한 번에 바꾸는 프레임 수. 클수록 크게 움직인다. */
+static size_t pff_step(size_t quota)
+{
+	return quota / 4 > PFF_STEP ? quota / 4 : PFF_STEP;
+}
+
+/* 프로세스 T의 spt가 살아 있으면 LIST에 모은다. 인터럽트를 끈 채 thread_foreach()로 호출된다.
+ * 모은 spt는 ws_daemon이 frame_table_lock을 놓을 때까지 없어지지 않는다. */
+static void ws_collect(struct thread *t, void *list)
+{
+	if (t->spt.ws_active)
+		list_push_back(list, &t->spt.ws_elem);
+}
+
+/* 한 구간이 끝난 프로세스의 WSS와 fault 빈도를 갱신하고, fault가 드물면 할당량을 줄인다.
+ * 줄이고 난 할당량을 *TOTAL에 더한다. frame_table_lock을 잡고 호출한다. */
+static void ws_update(struct supplemental_page_table *spt, size_t *total)
+{
+	spt->wss = (spt->wss * 3 + spt->ws_sample) / 4;
+	spt->ws_sample = 0;
+	spt->fault_rate = spt->fault_cnt * (TIMER_FREQ / WS_INTERVAL);
+	spt->fault_cnt = 0;
+
+	size_t floor = spt->wss > PFF_MIN_QUOTA ? spt->wss : PFF_MIN_QUOTA;
+	size_t step = pff_step(spt->frame_quota);
+	if (spt->fault_rate < PFF_LOW && spt->frame_quota > floor)
+		spt->frame_quota = spt->frame_quota > floor + step ? spt->frame_quota - step : floor;
+	*total += spt->frame_quota;
+}
+
+/* fault가 잦은 프로세스의 할당량을 전체 할당량이 유저 풀을 넘지 않는 만큼 늘린다.
+ * 모든 프로세스의 ws_update()가 끝난 뒤 frame_table_lock을 잡고 호출한다. */
+static void ws_grow(struct supplemental_page_table *spt, size_t *total)
+{
+	if (spt->fault_rate > PFF_HIGH && *total < frame_cnt) {
+		size_t step = pff_step(spt->frame_quota);
+		if (step > frame_cnt - *total)
+			step = frame_cnt - *total;
+		spt->frame_quota += step;
+		*total += step;
+	}
+	if (spt->rss > spt->frame_quota)
+		ws_over_quota = true;
+}
+
+/* working set 샘플러 스레드. WS_INTERVAL마다 사용 중인 프레임의 accessed 비트를 거둬
+ * 그 페이지의 프로세스에 세고, 프레임의 referenced에 옮겨 clock이 잃지 않게 한다.
+ * 그 다음 모든 프로세스의 WSS, fault 빈도, 할당량을 갱신한다. 인터럽트는 프로세스 목록을
+ * 훑는 동안에만 끄고, 값은 frame_table_lock 아래에서 갱신한다. */
+static void ws_daemon(void *aux UNUSED)
+{
+	for (;;) {
+		timer_sleep(WS_INTERVAL);
+
+		lock_acquire(&frame_table_lock);
+		for (size_t i = 0; i < frame_cnt; i++) {
+			struct frame *frame = &frame_table[i];
+			struct list_elem *e;
+			for (e = list_begin(&frame->page_list); e != list_end(&frame->page_list);
+				 e = list_next(e)) {
+				struct page *page = list_entry(e, struct page, frame_elem);
+				size_t cnt = page_harvest_accessed(page);
+				if (cnt > 0) {
+					frame->referenced = true;
+					page->owner_thread->spt.ws_sample += cnt;
+				}
+			}
+		}
+
+		struct list procs;
+		list_init(&procs);
+		enum intr_level old_level = intr_disable();
+		thread_foreach(ws_collect, &procs);
+		intr_set_level(old_level);
+
+		size_t total = 0;
+		struct list_elem *e;
+		ws_over_quota = false;
+		for (e = list_begin(&procs); e != list_end(&procs); e = list_next(e))
+			ws_update(list_entry(e, struct supplemental_page_table, ws_elem), &total);
+		for (e = list_begin(&procs); e != list_end(&procs); e = list_next(e))
+			ws_grow(list_entry(e, struct supplemental_page_table, ws_elem), &total);
+		lock_release(&frame_table_lock);
+	}
+}
+
+/* 프로세스 T의 working set 추정치와 fault 빈도를 출력한다 (커널 옵션 -ws). */
+void vm_print_ws(struct thread *t)
+{
+	struct supplemental_page_table *spt = &t->spt;
+	printf("%s: wss %zu pages, rss %zu frames, quota %zu frames, %u faults/s (%u faults)\n",
+		   t->name, spt->wss, spt->rss, spt->frame_quota, spt->fault_rate, spt->fault_total);
+}
+
 /* Growing the stack. */
 static bool vm_stack_growth(void *addr)
 {
@@ -191,9 +1498,73 @@ static bool vm_stack_growth(void *addr)
 	return true;
 }
 
-/* Handle the fault on write_protected page */
-static bool vm_handle_wp(struct page *page UNUSED)
+/* Handle the fault on write_protected page
+ * fork 이후 읽기 전용으로 공유 중인 프레임에 처음 쓰려고 할 때 호출된다 (copy-on-write).
+ * 다른 공유자가 남아 있으면 새 프레임에 내용을 복사해 옮겨 가고,
+ * 마지막 공유자라면 복사 없이 쓰기 권한만 되돌린다. */
+static bool vm_handle_wp(struct page *page)
 {
+	uint64_t *pml4 = page->owner_thread->pml4;
+
+	// zero 프레임을 보던 페이지에 처음 쓰는 경우 0으로 채운 새 프레임을 할당한다
+	if (VM_TYPE(page->operations->type) == VM_ANON && page->anon.zero) {
+		pml4_clear_page(pml4, page->va);
+		zero_cow_cnt++;
+		return vm_do_claim_page(page);
+	}
+
+	// 그 사이 교체되었다면 다음 접근에서 다시 fault가 나며 읽어 들인다
+	struct frame *old_frame = vm_frame_lock(page);
+	if (old_frame == NULL)
+		return true;
+
+	lock_acquire(&frame_table_lock);
+	bool exclusive = old_frame->ref_cnt == 1;
+	if (exclusive)
+		pml4_set_writable(pml4, page->va, true);
+	lock_release(&frame_table_lock);
+	vm_frame_unlock(old_frame);
+	if (exclusive) {
+		cow_reuse_cnt++;
+		return true;
+	}
+
+	// 아래에서 전체를 복사하므로 0으로 채울 필요가 없다.
+	// 교체를 일으킬 수 있으므로 다른 프레임 락을 잡지 않은 채로 구한다
+	struct frame *new_frame = vm_get_frame(false);
+	lock_acquire(&new_frame->lock);
+
+	old_frame = vm_frame_lock(page);
+	if (old_frame == NULL) {
+		// 새 프레임을 구하는 동안 교체되었다면 새 프레임을 돌려주고 다시 fault를 기다린다
+		lock_release(&new_frame->lock);
+		lock_acquire(&frame_table_lock);
+		frame_reset(new_frame);
+		lock_release(&frame_table_lock);
+		frame_free(new_frame);
+		return true;
+	}
+
+	lock_acquire(&frame_table_lock);
+	memcpy(new_frame->kva, old_frame->kva, PGSIZE);
+	frame_detach(old_frame, page);
+	bool last = old_frame->ref_cnt == 0;
+	if (last)
+		frame_reset(old_frame);
+	frame_attach(new_frame, page);
+	lock_release(&frame_table_lock);
+	vm_frame_unlock(old_frame);
+
+	if (last)
+		frame_free(old_frame);
+
+	// 기존 읽기 전용 매핑을 지우고 새 프레임을 쓰기 가능으로 매핑한다
+	pml4_clear_page(pml4, page->va);
+	bool success = pml4_set_page(pml4, page->va, new_frame->kva, true);
+	vm_frame_unpin(new_frame);
+	lock_release(&new_frame->lock);
+	cow_copy_cnt++;
+	return success;
 }
 
 /* Return true on success */
@@ -204,9 +1575,16 @@ bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user, bool write
 	// 1. 유효성 검사
 	if (spt == NULL || addr < VM_BOTTOM || is_kernel_vaddr(addr))
 		return false;
+	spt->fault_cnt++;
+	spt->fault_total++;
 
-	// 2. spt에 있는지 찾기
+	// 2. spt에 있는지 찾기 (영역에만 있고 처음 접근하는 페이지는 여기서 만든다)
+	// 2MB 구간 전체가 아직 비어 있는 anon 영역이면 2MB 페이지 하나로 한 번에 채운다
 	struct page *page = spt_find_page(spt, addr);
+	if (page == NULL && vm_map_huge(spt, addr))
+		return true;
+	if (page == NULL)
+		page = spt_lookup_page(spt, addr);
 
 	// Case 1: spt에 페이지가 있는 경우 (lazy loading, swap in)
 	if (page != NULL) {
@@ -216,8 +1594,16 @@ bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user, bool write
 			thread_exit(); // 쓰기 불가능한 페이지에 쓰기 시도
 
 		// 페이지가 물리 메모리에 없는 경우 -> 프레임 할당 및 로드
-		if (not_present)
+		// 새 anon 페이지를 읽기만 하는 경우에는 프레임 없이 zero 프레임을 보여 준다
+		if (not_present) {
+			if (!write && vm_map_zero_page(page))
+				return true;
 			return vm_do_claim_page(page);
+		}
+
+		// 공유 중인 프레임에 쓰려는 경우 -> copy-on-write
+		if (write)
+			return vm_handle_wp(page);
 
 		// 다른 종류의 fault (이론상 발생하지 않아야 함)
 		return false;
@@ -253,7 +1639,7 @@ bool vm_claim_page(void *va)
 		return false;
 
 	// 1. spt에서 페이지를 찾아서 page 구조체 획득
-	struct page *page = spt_find_page(&thread_current()->spt, va);
+	struct page *page = spt_lookup_page(&thread_current()->spt, va);
 	if (page == NULL)
 		return false;
 
@@ -264,40 +1650,606 @@ bool vm_claim_page(void *va)
 // 물레프레임 할당하여 페이지와 프레임을 연결한다
 static bool vm_do_claim_page(struct page *page)
 {
+	// 순차적으로 훑는 영역이라면 지나온 페이지들이 먼저 교체되게 한다
+	if (page->owner_thread == thread_current())
+		drop_behind(page);
+
+	// 0. readahead로 이미 프레임에 올라와 있다면 매핑만 한다
+	bool success;
+	if (page->frame != NULL && vm_map_resident(page, &success))
+		return success;
+
+	// 0. 실행 파일 세그먼트 페이지는 다른 프로세스가 읽어 둔 프레임이 있으면 공유한다
+	struct text_cache_entry key;
+	bool shareable = text_cache_key(page, &key);
+	if (shareable && text_cache_map(page, &key))
+		return true;
+
+	// 아직 읽지 않은 파일 페이지라면 초기화로 aux가 해제되기 전에 파일 구간을 기억해 둔다
+	struct file_extent ext;
+	bool around = page->owner_thread == thread_current() && file_extent_of(page, &ext);
+
 	// 1. 물리 프레임을 할당한다 (프레임에 의미있는 데이터는 없는 상태)
-	struct frame *frame = vm_get_frame();
+	struct frame *frame = vm_get_frame(page_needs_zero_frame(page));
+
+	// 2. 페이지와 프레임을 서로 연결한다. 내용이 채워질 때까지 프레임 락을 잡고 있으므로
+	// 같은 페이지에 난 다른 fault는 vm_map_resident()에서 기다린다
+	lock_acquire(&frame->lock);
+	if (!frame_attach_new(frame, page)) {
+		// 그 사이 pageout 데몬이 읽어 들였다면 그 프레임을 매핑한다
+		frame_discard(frame);
+		return vm_do_claim_page(page);
+	}
+
+	// 3. pte 생성 (fork 중에는 부모 페이지를 읽어 들일 수도 있으므로 소유 스레드 기준)
+	success = pml4_set_page(page->owner_thread->pml4, page->va, frame->kva, page->writable);
+	if (!success) {
+		lock_release(&frame->lock);
+		vm_free_frame(page);
+		return false;
+	}
+
+	// 이미 초기화된 페이지를 다시 읽어 들이는 경우 (swap in)
+	size_t ra_slot = BITMAP_ERROR;
+	if (VM_TYPE(page->operations->type) != VM_UNINIT) {
+		swap_in_cnt++;
+		if (VM_TYPE(page->operations->type) == VM_ANON && page->owner_thread == thread_current())
+			ra_slot = page->anon.swap_table_index;
+	}
+
+	// 4. 페이지 초기화 (uninit_initialize)
+	success = swap_in(page, frame->kva);
+	if (success && shareable)
+		text_cache_insert(&key, frame);
+
+	// 5. 내용이 채워진 뒤에 교체 대상에 올린다
+	vm_frame_unpin(frame);
+	lock_release(&frame->lock);
+
+	// 6. 스왑에서 읽어 왔다면 이웃 페이지도 미리 읽어 둔다
+	if (success && ra_slot != BITMAP_ERROR)
+		swap_readahead(page, ra_slot);
+	if (success && around)
+		fault_around(page, &ext);
+	return success;
+}
+
+/* 프레임은 있지만 매핑되지 않은 페이지(readahead로 읽어 둔 페이지)를 매핑한다.
+ * 그 사이 교체되어 프레임이 없다면 false를 반환하고, 매핑했다면 결과를 SUCCESS에 담아 true를 반환한다. */
+static bool vm_map_resident(struct page *page, bool *success)
+{
+	struct frame *frame = vm_frame_lock(page);
+	if (frame == NULL)
+		return false;
+
 	lock_acquire(&frame_table_lock);
-	list_push_back(&frame_list, &frame->frame_elem);
+	bool hit = VM_TYPE(page->operations->type) == VM_ANON && page->anon.readahead;
+	if (hit)
+		anon_readahead_settle(page);
+
+	// fault-around로 내용만 채워 둔 페이지는 이제 실제 타입의 페이지로 바꾼다
+	bool prefetched = VM_TYPE(page->operations->type) == VM_UNINIT;
+	if (prefetched && !uninit_transmute(page, frame->kva)) {
+		lock_release(&frame_table_lock);
+		vm_frame_unlock(frame);
+		vm_free_frame(page);
+		*success = false;
+		return true;
+	}
+
+	// 공유 중인 프레임은 첫 쓰기 때 복사하도록 읽기 전용으로 매핑한다
+	bool writable = page->writable && frame->ref_cnt == 1;
+	*success = pml4_set_page(page->owner_thread->pml4, page->va, frame->kva, writable);
 	lock_release(&frame_table_lock);
+	vm_frame_unlock(frame);
 
-	// 2. 페이지와 프레임을 서로 연결한다
-	frame->page = page;
-	page->frame = frame;
+	if (hit) {
+		ra_hit_cnt++;
+		page->owner_thread->spt.ra_hits++;
+	}
+	if (prefetched)
+		fa_hit_cnt++;
+	return true;
+}
+
+/* 스왑 슬롯 SLOT에서 방금 읽어 들인 PAGE 뒤쪽의 이웃 페이지들을 미리 읽어 둔다.
+ * 같은 spt에서 연속된 가상 주소이고 스왑 슬롯도 가까운 anon 페이지만 읽으며,
+ * 매핑은 하지 않고 첫 접근 때 vm_map_resident()가 매핑한다.
+ * 창 크기는 지난 readahead의 적중률에 따라 조절하되, RANDOM 영역에서는 읽지 않고
+ * SEQUENTIAL 영역에서는 최대로 읽는다. 여유 프레임이 모자라면 멈춘다. */
+static void swap_readahead(struct page *page, size_t slot)
+{
+	struct supplemental_page_table *spt = &page->owner_thread->spt;
+
+	// madvise()로 받은 힌트가 있으면 적중률과 상관없이 따른다
+	struct vma *vma = vma_find(spt, page->va);
+	if (vma != NULL && vma->advice == VM_ADV_RANDOM)
+		return;
+
+	if (spt->ra_issued > 0) {
+		if (spt->ra_hits * 2 >= spt->ra_issued)
+			spt->ra_window = spt->ra_window * 2 < RA_WINDOW_MAX ? spt->ra_window * 2 : RA_WINDOW_MAX;
+		else
+			spt->ra_window = spt->ra_window / 2 > RA_WINDOW_MIN ? spt->ra_window / 2 : RA_WINDOW_MIN;
+	}
+	spt->ra_issued = spt->ra_hits = 0;
+
+	unsigned window = spt->ra_window;
+	if (vma != NULL && vma->advice == VM_ADV_SEQUENTIAL)
+		window = RA_WINDOW_MAX;
+	for (unsigned i = 1; i <= window; i++) {
+		struct page *ra_page = spt_find_page(spt, page->va + i * PGSIZE);
+		if (ra_page == NULL)
+			break;
+		if (VM_TYPE(ra_page->operations->type) != VM_ANON || ra_page->frame != NULL)
+			continue;
+
+		size_t ra_slot = ra_page->anon.swap_table_index;
+		if (ra_slot == BITMAP_ERROR
+			|| (ra_slot > slot ? ra_slot - slot : slot - ra_slot) > RA_SLOT_DISTANCE)
+			continue;
+
+		// 미리 읽기 때문에 교체가 일어나지 않도록 워터마크 위의 여유 프레임만 쓴다
+		if (free_frame_cnt <= vm_pageout_low)
+			break;
+		struct frame *frame = frame_alloc(0);
+		if (frame == NULL)
+			break;
 
-	// 3. pte 생성
-	bool success = pml4_set_page(thread_current()->pml4, page->va, frame->kva, page->writable);
-	if (!success)
+		lock_acquire(&frame->lock);
+		if (!frame_attach_new(frame, ra_page)) {
+			frame_discard(frame);
+			continue;
+		}
+
+		bool read = anon_swap_readahead(ra_page, frame->kva);
+		lock_release(&frame->lock);
+		if (!read) {
+			vm_free_frame(ra_page);
+			continue;
+		}
+		vm_frame_unpin(frame);
+		spt->ra_issued++;
+		ra_read_cnt++;
+	}
+}
+
+/* PAGE를 읽어 들일 때 프레임이 0으로 채워져 있어야 하는지 판단한다.
+ * 파일이나 스왑에서 읽는 페이지는 읽은 뒤 남는 부분까지 스스로 채우므로 필요 없고,
+ * 새 anon 페이지(스택, zero 프레임을 보던 페이지)만 0으로 채운 프레임이 필요하다. */
+static bool page_needs_zero_frame(struct page *page)
+{
+	switch (VM_TYPE(page->operations->type)) {
+		case VM_UNINIT:
+			return VM_TYPE(page->uninit.type) == VM_ANON && !(page->uninit.type & VM_LOAD_MARKER);
+		case VM_ANON:
+			return page->anon.zero;
+		default:
+			return false;
+	}
+}
+
+/* PAGE가 아직 한 번도 쓰이지 않아 내용이 모두 0인 anon 페이지라면 (bss, 새 anon 영역)
+ * 프레임을 할당하지 않고 공용 zero 프레임을 읽기 전용으로 매핑한다.
+ * 이후 첫 쓰기는 vm_handle_wp()에서 진짜 프레임을 할당한다. */
+static bool vm_map_zero_page(struct page *page)
+{
+	if (VM_TYPE(page->operations->type) != VM_UNINIT || VM_TYPE(page->uninit.type) != VM_ANON
+		|| page->frame != NULL)
 		return false;
 
-	// 4. 페이지 초기화 (uninit_initialize)
-	return swap_in(page, frame->kva);
+	if (page->uninit.type & VM_LOAD_MARKER) {
+		struct vm_load_aux *aux = page->uninit.aux;
+		if (aux->page_read_bytes != 0)
+			return false;
+	} else if (page->uninit.init != NULL || (page->uninit.type & VM_STACK_MAKER))
+		return false;
+
+	if (!uninit_transmute(page, zero_kva))
+		return false;
+	page->anon.zero = true;
+
+	if (!pml4_set_page(page->owner_thread->pml4, page->va, zero_kva, false))
+		return false;
+	zero_map_cnt++;
+	return true;
+}
+
+static void huge_check_empty(struct page *page UNUSED, void *empty)
+{
+	*(bool *)empty = false;
+}
+
+/* ADDR를 포함하는 2MB 구간이 통째로 0으로 채워질 anon 영역 안에 있고 아직 만들어진 페이지가
+ * 없다면, 물리적으로 연속이고 정렬된 프레임 512개를 한 번에 할당해 2MB 페이지 하나로 매핑한다.
+ * 4KB 페이지마다 struct page와 프레임 테이블 원소는 그대로 있으므로 교체는 4KB 단위로 일어나고,
+ * 그때 mmu.c가 2MB 매핑을 4KB 매핑으로 쪼갠다.
+ * 쪼갤 메모리가 없으면 mmu.c는 매핑을 통째로 지우는데, 그래도 되는 것은 anon 페이지가
+ * dirty 비트와 상관없이 스왑에 쓰이기 때문이다. 그래서 파일 페이지에는 쓰지 않는다. */
+static bool vm_map_huge(struct supplemental_page_table *spt, void *addr)
+{
+	if (!vm_huge_pages)
+		return false;
+
+	void *base = (void *)((uint64_t)addr & ~(HUGE_PGSIZE - 1));
+	struct vma *vma = vma_find(spt, addr);
+	if (vma == NULL || VM_TYPE(vma->type) != VM_ANON || base < vma->start
+		|| base + HUGE_PGSIZE > vma->end)
+		return false;
+
+	// 실행 파일 데이터 세그먼트는 파일에서 읽을 부분이 끝난 bss 구간만, 그 밖에는 init이 없는 영역만
+	if (vma->type & VM_LOAD_MARKER) {
+		if ((size_t)(base - vma->start) < vma->read_bytes)
+			return false;
+	} else if (vma->init != NULL)
+		return false;
+
+	// 교체를 일으키지 않도록 워터마크 위로 여유가 충분할 때만
+	if (free_frame_cnt < vm_pageout_high + HUGE_PGCNT)
+		return false;
+
+	bool empty = true;
+	spt_for_each(spt, base, base + HUGE_PGSIZE, huge_check_empty, &empty);
+	if (!empty)
+		return false;
+
+	void *kva = palloc_get_aligned(PAL_USER | PAL_ZERO, HUGE_PGCNT, HUGE_PGCNT);
+	if (kva == NULL)
+		return false;
+
+	lock_acquire(&frame_table_lock);
+	for (size_t i = 0; i < HUGE_PGCNT; i++) {
+		struct frame *frame = vm_frame_lookup(kva + i * PGSIZE);
+		ASSERT(frame->page == NULL && frame->ref_cnt == 0);
+		frame->pin_cnt = 1;
+	}
+	free_frame_cnt -= HUGE_PGCNT;
+	if (free_frame_cnt < vm_pageout_low)
+		pageout_wakeup();
+	lock_release(&frame_table_lock);
+
+	// 구간의 페이지를 만들어 0으로 채워진 프레임에 하나씩 붙인다
+	size_t cnt;
+	for (cnt = 0; cnt < HUGE_PGCNT; cnt++) {
+		void *va = base + cnt * PGSIZE;
+		struct frame *frame = vm_frame_lookup(kva + cnt * PGSIZE);
+		if (!vma_populate(vma, va))
+			break;
+		struct page *page = spt_find_page(spt, va);
+		if (!uninit_transmute(page, frame->kva)) {
+			spt_remove_page(spt, page);
+			break;
+		}
+
+		lock_acquire(&frame->lock);
+		lock_acquire(&frame_table_lock);
+		frame_attach(frame, page);
+		lock_release(&frame_table_lock);
+		lock_release(&frame->lock);
+	}
+
+	bool success = cnt == HUGE_PGCNT
+				   && pml4_set_huge_page(thread_current()->pml4, base, kva, vma->writable);
+	if (!success) {
+		// 만든 페이지는 프레임과 함께 정리하고, 붙이지 못한 프레임은 바로 반납한다
+		for (size_t i = 0; i < cnt; i++)
+			spt_remove_page(spt, spt_find_page(spt, base + i * PGSIZE));
+		for (size_t i = cnt; i < HUGE_PGCNT; i++) {
+			struct frame *frame = vm_frame_lookup(kva + i * PGSIZE);
+			lock_acquire(&frame_table_lock);
+			frame_reset(frame);
+			lock_release(&frame_table_lock);
+			frame_free(frame);
+		}
+		return false;
+	}
+
+	for (size_t i = 0; i < HUGE_PGCNT; i++)
+		vm_frame_unpin(vm_frame_lookup(kva + i * PGSIZE));
+	huge_map_cnt++;
+	return true;
+}
+
+/* PAGE가 아직 읽지 않은 mmap 또는 실행 파일 세그먼트 페이지라면 읽어야 할 파일 구간을 EXT에 채운다. */
+static bool file_extent_of(struct page *page, struct file_extent *ext)
+{
+	if (VM_TYPE(page->operations->type) != VM_UNINIT)
+		return false;
+
+	if (page->uninit.type & VM_LOAD_MARKER) {
+		struct vm_load_aux *aux = page->uninit.aux;
+		*ext = (struct file_extent){
+			.file = page->owner_thread->current_file,
+			.offset = aux->offset,
+			.read_bytes = aux->page_read_bytes,
+			.window = aux->fault_around,
+			.shared = false,
+		};
+		return true;
+	}
+
+	if (VM_TYPE(page->uninit.type) == VM_FILE) {
+		struct mmap_aux *aux = page->uninit.aux;
+		*ext = (struct file_extent){
+			.file = aux->file,
+			.offset = aux->offset,
+			.read_bytes = aux->page_read_bytes,
+			.window = aux->fault_around,
+			.shared = aux->shared,
+		};
+		return true;
+	}
+	return false;
+}
+
+/* 미리 읽은 파일 페이지 PAGE의 프레임 KVA에서 실제로 읽은 READ 바이트 뒤를 0으로 채운다.
+ * mmap 페이지는 lazy_load_file()처럼 읽은 길이를 aux에 남겨, file 페이지로 바뀐 뒤
+ * 파일 끝을 넘는 부분까지 다시 쓰지 않게 한다. */
+static void file_extent_filled(struct page *page, void *kva, int read)
+{
+	int n = read > 0 ? read : 0;
+	memset(kva + n, 0, PGSIZE - n);
+
+	if (!(page->uninit.type & VM_LOAD_MARKER) && VM_TYPE(page->uninit.type) == VM_FILE)
+		((struct mmap_aux *)page->uninit.aux)->page_read_bytes = n;
+}
+
+/* 방금 읽어 들인 PAGE를 포함하는 창(ext->window 페이지 단위로 정렬)에서 같은 매핑의
+ * 아직 읽지 않은 이웃 페이지들을 함께 읽어 둔다.
+ * 이웃 페이지는 uninit 상태로 프레임만 붙여 두고 매핑하지 않으며, 첫 접근 때
+ * vm_map_resident()가 실제 타입으로 바꾸어 매핑한다. 그래서 fault는 남지만 디스크를 읽지 않는다.
+ * 교체를 일으키지 않도록 워터마크 위의 여유 프레임만 쓴다. */
+static void fault_around(struct page *page, struct file_extent *ext)
+{
+	if (ext->window <= 1)
+		return;
+
+	struct supplemental_page_table *spt = &page->owner_thread->spt;
+	void *start = page->va - (pg_no(page->va) % ext->window) * PGSIZE;
+	struct page *pages[VM_FAULT_AROUND_MAX];
+	int read_bytes[VM_FAULT_AROUND_MAX];
+	size_t cnt = 0;
+
+	for (unsigned i = 0; i < ext->window; i++) {
+		void *va = start + i * PGSIZE;
+		if (va == page->va)
+			continue;
+
+		// 같은 파일에서 주소 차이만큼 떨어진 위치를 읽는 페이지만 같은 매핑으로 본다
+		struct page *p = spt_lookup_page(spt, va);
+		struct file_extent e;
+		if (p == NULL || p->frame != NULL || !file_extent_of(p, &e) || e.file != ext->file
+			|| e.shared != ext->shared || e.offset != ext->offset + (va - page->va))
+			continue;
+		// 읽을 내용이 없는 페이지(bss)는 zero 프레임으로 충분하다
+		if (e.read_bytes == 0)
+			continue;
+
+		struct text_cache_entry key;
+		if (e.shared && text_cache_key(p, &key) && text_cache_map(p, &key))
+			continue;
+
+		if (free_frame_cnt <= vm_pageout_low)
+			break;
+		struct frame *frame = frame_alloc(0);
+		if (frame == NULL)
+			break;
+
+		lock_acquire(&frame->lock);
+		if (!frame_attach_new(frame, p)) {
+			frame_discard(frame);
+			continue;
+		}
+		pages[cnt++] = p;
+	}
+	if (cnt == 0)
+		return;
+
+	// 창 안의 페이지를 한 번에 읽는다
+	for (size_t i = 0; i < cnt; i++) {
+		struct file_extent e;
+		file_extent_of(pages[i], &e);
+		read_bytes[i] = file_read_at(e.file, pages[i]->frame->kva, e.read_bytes, e.offset);
+	}
+
+	for (size_t i = 0; i < cnt; i++) {
+		struct page *p = pages[i];
+		struct frame *frame = p->frame;
+		file_extent_filled(p, frame->kva, read_bytes[i]);
+
+		struct text_cache_entry key;
+		if (ext->shared && text_cache_key(p, &key))
+			text_cache_insert(&key, frame);
+		vm_frame_unpin(frame);
+		lock_release(&frame->lock);
+		fa_read_cnt++;
+	}
+}
+
+/* ADDR부터 LENGTH 바이트와 겹치는 영역과 그 안의 아직 읽지 않은 파일 페이지들의
+ * fault-around 창 크기를 PAGES로 바꾼다. 1 이하면 fault-around를 하지 않는다. */
+void vm_set_fault_around(void *addr, size_t length, unsigned pages)
+{
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	if (pages > VM_FAULT_AROUND_MAX)
+		pages = VM_FAULT_AROUND_MAX;
+
+	struct list_elem *e;
+	for (e = list_begin(&spt->vma_list); e != list_end(&spt->vma_list); e = list_next(e)) {
+		struct vma *vma = list_entry(e, struct vma, elem);
+		if (vma->start < addr + length && addr < vma->end)
+			vma->fault_around = pages;
+	}
+
+	for (void *va = pg_round_down(addr); va < addr + length; va += PGSIZE) {
+		struct page *page = spt_find_page(spt, va);
+		if (page == NULL || VM_TYPE(page->operations->type) != VM_UNINIT)
+			continue;
+
+		if (page->uninit.type & VM_LOAD_MARKER)
+			((struct vm_load_aux *)page->uninit.aux)->fault_around = pages;
+		else if (VM_TYPE(page->uninit.type) == VM_FILE)
+			((struct mmap_aux *)page->uninit.aux)->fault_around = pages;
+	}
+}
+
+/* PAGE가 SEQUENTIAL 힌트를 받은 영역에 있으면 DROP_BEHIND 페이지 뒤부터 DROP_BEHIND개 페이지의
+ * 접근 기록을 지운다. 순차적으로 훑는 프로그램은 지나간 페이지를 다시 보지 않으므로
+ * 다음 교체 때 clock이 두 번째 기회를 주지 않고 이 페이지들부터 내보낸다. */
+static void drop_behind(struct page *page)
+{
+	struct supplemental_page_table *spt = &page->owner_thread->spt;
+	struct vma *vma = vma_find(spt, page->va);
+	if (vma == NULL || vma->advice != VM_ADV_SEQUENTIAL)
+		return;
+
+	uint64_t *pml4 = page->owner_thread->pml4;
+	lock_acquire(&frame_table_lock);
+	for (size_t i = DROP_BEHIND; i < 2 * DROP_BEHIND; i++) {
+		void *va = page->va - i * PGSIZE;
+		if (va < vma->start || va > page->va)
+			break;
+
+		struct page *p = spt_find_page(spt, va);
+		if (p == NULL || p->frame == NULL)
+			continue;
+		pml4_set_accessed(pml4, va, false);
+		p->frame->referenced = false;
+	}
+	lock_release(&frame_table_lock);
+}
+
+/* 범위 안에서 디스크를 읽어야 하는 페이지들을 WILLNEED_MAX개씩 요청으로 묶어 pageout 데몬에
+ * 맡기고 기다리지 않고 돌아온다 (MADV_WILLNEED). 페이지 객체는 여기서 만들어 두므로
+ * 데몬은 spt를 건드리지 않는다. 메모리가 모자라면 힌트이므로 조용히 그만둔다. */
+static void madvise_willneed(struct supplemental_page_table *spt, void *start, void *end)
+{
+	struct willneed_req *req = NULL;
+
+	for (void *va = start; va < end; va += PGSIZE) {
+		struct page *page = spt_lookup_page(spt, va);
+		if (page == NULL || page->frame != NULL || !page_needs_read(page))
+			continue;
+
+		if (req == NULL) {
+			req = malloc(sizeof *req);
+			if (req == NULL)
+				return;
+			req->spt = spt;
+			req->cnt = 0;
+		}
+		req->pages[req->cnt++] = page;
+		if (req->cnt < WILLNEED_MAX && va + PGSIZE < end)
+			continue;
+
+		lock_acquire(&frame_table_lock);
+		list_push_back(&willneed_queue, &req->elem);
+		spt->willneed_cnt++;
+		pageout_wakeup();
+		lock_release(&frame_table_lock);
+		req = NULL;
+	}
+}
+
+/* 프레임이 없는 PAGE를 읽어 들이려면 파일이나 swap 디스크를 읽어야 하는지 판단한다.
+ * 0으로 채울 페이지, 압축 스왑에 있는 페이지, text cache로 공유하는 실행 파일 페이지는
+ * fault 때 읽어도 충분하므로 false. frame_table_lock을 잡고 있거나 PAGE의 소유 스레드가 호출한다. */
+static bool page_needs_read(struct page *page)
+{
+	struct file_extent ext;
+	if (file_extent_of(page, &ext))
+		return ext.read_bytes > 0 && !ext.shared;
+	return VM_TYPE(page->operations->type) == VM_ANON && !page->anon.zero
+		   && page->anon.zswap_index == BITMAP_ERROR
+		   && page->anon.swap_table_index != BITMAP_ERROR;
+}
+
+/* 범위 안의 anon 페이지를 프레임과 스왑 슬롯까지 모두 버린다 (MADV_DONTNEED).
+ * 영역에 속한 페이지는 다음 접근 때 영역에서 처음처럼 다시 만들어진다 (bss는 0, 데이터는 파일 내용).
+ * 영역이 없는 스택 페이지는 계속 접근할 수 있도록 빈 anon 페이지로 바꾼다. */
+static void madvise_dontneed(struct supplemental_page_table *spt, void *start, void *end)
+{
+	for (void *va = start; va < end; va += PGSIZE) {
+		struct page *page = spt_find_page(spt, va);
+		if (page == NULL || page_get_type(page) != VM_ANON)
+			continue;
+
+		bool refill = vma_find(spt, va) == NULL;
+		bool writable = page->writable;
+		spt_remove_page(spt, page);
+		if (refill)
+			vm_alloc_page(VM_ANON | VM_STACK_MAKER, va, writable);
+	}
+}
+
+/* [ADDR, ADDR + LENGTH)에 접근 방식 힌트 ADVICE를 적용한다.
+ * 범위 안에 영역에도 spt에도 없는 페이지가 있으면 아무것도 하지 않고 false를 반환한다.
+ * 영역에 남는 힌트는 범위와 겹치는 영역 전체에 적용된다 (영역을 쪼개지 않는다). */
+bool vm_madvise(void *addr, size_t length, enum vm_advice advice)
+{
+	struct supplemental_page_table *spt = &thread_current()->spt;
+	void *end = pg_round_up(addr + length);
+
+	for (void *va = addr; va < end; va += PGSIZE)
+		if (spt_find_page(spt, va) == NULL && vma_find(spt, va) == NULL)
+			return false;
+
+	unsigned window;
+	switch (advice) {
+		case VM_ADV_NORMAL:
+			window = VM_FAULT_AROUND_DEFAULT;
+			break;
+		case VM_ADV_RANDOM:
+			window = 1;
+			break;
+		case VM_ADV_SEQUENTIAL:
+			window = VM_FAULT_AROUND_MAX;
+			break;
+		case VM_ADV_WILLNEED:
+			madvise_willneed(spt, addr, end);
+			return true;
+		case VM_ADV_DONTNEED:
+			madvise_dontneed(spt, addr, end);
+			return true;
+		default:
+			return false;
+	}
+
+	struct list_elem *e;
+	for (e = list_begin(&spt->vma_list); e != list_end(&spt->vma_list); e = list_next(e)) {
+		struct vma *vma = list_entry(e, struct vma, elem);
+		if (vma->start < end && addr < vma->end)
+			vma->advice = advice;
+	}
+	vm_set_fault_around(addr, end - addr, window);
+	return true;
 }
 
 // spt helpers
-static uint64_t spt_hash_func(const struct hash_elem *elem, void *aux UNUSED);
-static uint64_t spt_hash_func(const struct hash_elem *elem, void *aux UNUSED);
-static bool spt_hash_less_func(const struct hash_elem *elem_a, const struct hash_elem *elem_b,
-							   void *aux UNUSED);
-static void remove_page_from_spt(struct hash_elem *elem, void *aux UNUSED);
-static void copy_page_from_spt(struct hash_elem *elem, void *aux);
-
-// 해시테이블을 초기화하는 함수
+static void remove_page_from_spt(struct page *page, void *spt);
+static void copy_page_from_spt(struct page *src_page, void *aux UNUSED);
+static bool vm_share_page(struct page *dst, struct page *src);
+
+// spt를 초기화하는 함수. radix tree는 첫 페이지를 등록할 때 만든다
 void supplemental_page_table_init(struct supplemental_page_table *spt)
 {
 	if (spt == NULL)
 		PANIC("(supplemental_page_table_init) spt NULL!");
-	if (!hash_init(&spt->spt_hash, spt_hash_func, spt_hash_less_func, NULL))
-		PANIC("(supplemental_page_table_init) hash init FAIL!");
+	spt->spt_root = NULL;
+	spt->page_cnt = 0;
+	list_init(&spt->vma_list);
+	spt->heap_start = spt->brk = NULL;
+	spt->ra_window = RA_WINDOW_INIT;
+	spt->ra_issued = spt->ra_hits = 0;
+	spt->rss = spt->wss = spt->ws_sample = 0;
+	spt->frame_quota = PFF_INIT_QUOTA;
+	spt->fault_cnt = spt->fault_rate = spt->fault_total = 0;
+	spt->willneed_cnt = 0;
+
+	// 다른 필드를 모두 채운 뒤에 ws_daemon이 보게 한다
+	lock_acquire(&frame_table_lock);
+	spt->ws_active = true;
+	lock_release(&frame_table_lock);
 }
 
 /* Copy supplemental page table from src to dst */
@@ -309,10 +2261,17 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst,
 		return false;
 
 	// 1. dst를 비운다
-	hash_clear(&dst->spt_hash, remove_page_from_spt);
+	spt_for_each(dst, NULL, (void *)KERN_BASE, remove_page_from_spt, dst);
+	vma_kill(dst);
+
+	// 2. 영역을 먼저 복사한다. 아직 만들어지지 않은 페이지는 자식이 fault 때 영역에서 만든다
+	if (!vma_copy(dst, src))
+		return false;
+	dst->heap_start = src->heap_start;
+	dst->brk = src->brk;
 
-	// 2. 순회를 하며 copy_page_from_spt 호출
-	hash_apply(&src->spt_hash, copy_page_from_spt);
+	// 3. 주소 순으로 순회를 하며 copy_page_from_spt 호출
+	spt_for_each(src, NULL, (void *)KERN_BASE, copy_page_from_spt, NULL);
 
 	return true;
 }
@@ -321,65 +2280,76 @@ void supplemental_page_table_kill(struct supplemental_page_table *spt)
 {
 	if (spt == NULL)
 		PANIC("(supplemental_page_table_kill) spt null poiter!");
-	hash_destroy(&spt->spt_hash, remove_page_from_spt);
-}
 
-// va로 해시키를 만들어서 반환하는 함수
-static uint64_t spt_hash_func(const struct hash_elem *elem, void *aux UNUSED)
-{
-	struct page *curr_page = hash_entry(elem, struct page, spt_hash_elem);
-	return hash_bytes(&curr_page->va, sizeof(curr_page->va));
-}
+	// ws_daemon이 이 spt를 모아 가지 않게 한다. 이미 모아 갔다면 갱신이 끝날 때까지 기다린다
+	lock_acquire(&frame_table_lock);
+	spt->ws_active = false;
+	lock_release(&frame_table_lock);
 
-/* page가 같은지, 혹은 순서가 앞서는지를 va를 기준으로 판단하는 함수
- * a가 b보다 작으면 true를 반환한다. */
-static bool spt_hash_less_func(const struct hash_elem *elem_a, const struct hash_elem *elem_b,
-							   void *aux UNUSED)
-{
-	struct page *page_a = hash_entry(elem_a, struct page, spt_hash_elem);
-	struct page *page_b = hash_entry(elem_b, struct page, spt_hash_elem);
-	return page_a->va < page_b->va;
+	// mmap 영역의 dirty 페이지는 페이지마다 따로 쓰지 않고 먼저 모아서 쓴다
+	struct list_elem *e;
+	for (e = list_begin(&spt->vma_list); e != list_end(&spt->vma_list); e = list_next(e)) {
+		struct vma *vma = list_entry(e, struct vma, elem);
+		if (vma->owns_file)
+			vm_writeback_range(vma->start, vma->end);
+	}
+
+	spt_for_each(spt, NULL, (void *)KERN_BASE, remove_page_from_spt, spt);
+	if (spt->spt_root != NULL)
+		spt_free_table(spt->spt_root, 0);
+	spt->spt_root = NULL;
+	vma_kill(spt);
 }
 
 // spt에서 해당 page를 삭제합니다
 // writeback을 위해 VM_FILE은 swap_out함수를 호출합니다.
-static void remove_page_from_spt(struct hash_elem *elem, void *aux UNUSED)
+static void remove_page_from_spt(struct page *page, void *spt)
 {
-	struct page *curr_page = hash_entry(elem, struct page, spt_hash_elem);
-	vm_dealloc_page(curr_page);
+	spt_remove_page(spt, page);
 }
 
 // fork시 부모 프로세스의 spt에서 자식 프로세스의 spt로 한 개의 페이지를 복사한다
-// @param elem: 부모 SPT의 한 페이지를 가리키는 hash element
-static void copy_page_from_spt(struct hash_elem *elem, void *aux)
+// @param src_page: 부모 SPT의 한 페이지
+static void copy_page_from_spt(struct page *src_page, void *aux UNUSED)
 {
-	// 1. 부모 페이지 가져온다
-	struct page *src_page = hash_entry(elem, struct page, spt_hash_elem);
 	void *va = src_page->va;
 	bool writable = src_page->writable;
 
 	switch (VM_TYPE(src_page->operations->type)) {
 		case VM_UNINIT:
-			enum vm_type type = page_get_type(src_page);
-			if (src_page->uninit.type & VM_LOAD_MARKER) {
-				struct vm_load_aux *dst_aux = malloc(sizeof(*dst_aux));
-				memcpy(dst_aux, src_page->uninit.aux, sizeof(*dst_aux));
-				vm_alloc_page_with_initializer(type, va, writable, src_page->uninit.init, dst_aux);
+			// 영역에 속한 페이지는 자식이 처음 접근할 때 자기 영역에서 다시 만든다
+			if (vma_find(&thread_current()->spt, va) != NULL)
+				return;
+			if (page_get_type(src_page) == VM_ANON && src_page->uninit.init == NULL)
+				vm_alloc_page(page_get_type(src_page), va, writable);
+			return;
+		case VM_FILE:
+			// 실행 파일 세그먼트는 자식에서 fault가 날 때 text cache로 부모 프레임을 공유한다
+			if (src_page->file.shared)
 				return;
-			}
 
-			if (type == VM_FILE) {
-				struct mmap_aux *dst_aux = malloc(sizeof(*dst_aux));
-				memcpy(dst_aux, src_page->uninit.aux, sizeof(*dst_aux));
-				vm_alloc_page_with_initializer(type, va, writable, src_page->uninit.init, dst_aux);
+			// 아직 쓰지 않은 내용이 있을 수 있으므로 자식이 다시 연 파일을 가리키는 페이지로 복사한다
+			struct vma *vma = vma_find(&thread_current()->spt, va);
+			struct mmap_aux *dst_aux = malloc(sizeof(*dst_aux));
+			if (vma == NULL || dst_aux == NULL) {
+				free(dst_aux);
+				return;
+			}
+			*dst_aux = (struct mmap_aux){
+				.file = vma->file,
+				.offset = src_page->file.offset,
+				.page_read_bytes = src_page->file.page_read_bytes,
+			};
+			if (!vm_alloc_page_with_initializer(VM_FILE, va, writable, NULL, dst_aux)) {
+				free(dst_aux);
 				return;
 			}
-			return;
-		case VM_FILE:
-			vm_alloc_page_with_initializer(VM_FILE, va, writable, NULL, &src_page->file);
 			break;
 		case VM_ANON:
-			vm_alloc_page_with_initializer(VM_ANON, va, writable, NULL, &src_page->anon);
+			vm_alloc_page_with_initializer(VM_ANON, va, writable, NULL, NULL);
+			// zero 프레임만 보고 있던 페이지는 자식도 새 anon 페이지로 두면 된다
+			if (src_page->anon.zero)
+				return;
 			break;
 	}
 
@@ -389,10 +2359,64 @@ static void copy_page_from_spt(struct hash_elem *elem, void *aux)
 	if (dst_page == NULL)
 		PANIC("copy_page_from_spt: dst_page not found.");
 
-	// 프레임 즉시 할당
+	// 부모 페이지가 교체되어 있거나 readahead로 읽어 두기만 했다면 먼저 부모 쪽에 매핑한다
+	bool resident = src_page->frame != NULL;
+	if (VM_TYPE(src_page->operations->type) == VM_ANON && src_page->anon.readahead)
+		resident = false;
+	if (!resident && !vm_do_claim_page(src_page))
+		return;
+
+	// anon 페이지는 프레임을 공유하고 첫 쓰기 때 복사한다 (copy-on-write)
+	if (VM_TYPE(src_page->operations->type) == VM_ANON) {
+		vm_share_page(dst_page, src_page);
+		return;
+	}
+
+	// 프레임 즉시 할당. 초기화가 끝나면 aux는 더 쓰이지 않는다
+	void *dst_aux = dst_page->uninit.aux;
 	if (!vm_do_claim_page(dst_page))
 		return;
+	free(dst_aux);
 
-	// 물리 메모리 복사
-	memcpy(dst_page->frame->kva, src_page->frame->kva, PGSIZE);
-}
\ No newline at end of file
+	// 물리 메모리 복사. 복사하는 동안 두 프레임이 교체되지 않도록 pin한다.
+	// 부모 페이지가 그 사이 교체되었다면 수정된 내용은 파일에 쓰였으므로 자식이 읽은 내용이 맞다
+	struct frame *dst_frame, *src_frame;
+	while ((dst_frame = vm_frame_pin(dst_page)) == NULL)
+		if (!vm_do_claim_page(dst_page))
+			return;
+	src_frame = vm_frame_pin(src_page);
+	if (src_frame != NULL) {
+		memcpy(dst_frame->kva, src_frame->kva, PGSIZE);
+		vm_frame_unpin(src_frame);
+		fork_copy_cnt++;
+	}
+	vm_frame_unpin(dst_frame);
+}
+
+/* fork 시 부모 페이지 SRC가 쓰는 프레임을 자식 페이지 DST와 공유한다.
+ * 두 프로세스 모두 읽기 전용으로 매핑하고, 첫 쓰기 때 vm_handle_wp()에서 복사한다. */
+static bool vm_share_page(struct page *dst, struct page *src)
+{
+	// uninit 상태인 자식 페이지를 anon 페이지로 바꾼다 (init 콜백이 없으므로 읽기는 없다).
+	// 공유 프레임도 교체될 수 있으므로 붙이기 전에 바꿔 두어야 교체 시 swap 슬롯을 나눠 받는다
+	if (!uninit_transmute(dst, NULL))
+		return false;
+
+	for (;;) {
+		struct frame *frame = vm_frame_lock(src);
+		if (frame != NULL) {
+			lock_acquire(&frame_table_lock);
+			frame_attach(frame, dst);
+			pml4_set_writable(src->owner_thread->pml4, src->va, false);
+			bool success = pml4_set_page(dst->owner_thread->pml4, dst->va, frame->kva, false);
+			lock_release(&frame_table_lock);
+			vm_frame_unlock(frame);
+			cow_share_cnt++;
+			return success;
+		}
+
+		// 그 사이 부모 페이지가 교체되었다면 다시 읽어 들인다
+		if (!vm_do_claim_page(src))
+			return false;
+	}
+}
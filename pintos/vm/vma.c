@@ -0,0 +1,231 @@
+/* vma.c: 가상 주소 영역(VMA) 관리.
+ *
+ * mmap이나 ELF 세그먼트처럼 연속된 페이지를 같은 방식으로 채우는 영역을
+ * supplemental_page_table의 vma_list에 시작 주소 순으로 보관한다.
+ * 영역을 만드는 비용은 페이지 수와 상관없이 O(영역 수)이고,
+ * struct page는 각 페이지에 처음 fault가 날 때 vma_populate()가 만든다. */
+
+#include "vm/vma.h"
+#include "threads/malloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "vm/vm.h"
+
+static bool vma_less(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED);
+static void vma_remove_page(struct page *page, void *spt);
+
+/* TMPL과 같은 내용의 영역을 SPT에 추가하고 반환한다.
+ * 기존 영역과 겹치거나 메모리가 없으면 NULL을 반환한다. */
+struct vma *vma_insert(struct supplemental_page_table *spt, const struct vma *tmpl)
+{
+	ASSERT(pg_ofs(tmpl->start) == 0 && pg_ofs(tmpl->end) == 0);
+	ASSERT(tmpl->start < tmpl->end);
+
+	if (vma_overlaps(spt, tmpl->start, tmpl->end))
+		return NULL;
+
+	struct vma *vma = malloc(sizeof(*vma));
+	if (vma == NULL)
+		return NULL;
+
+	*vma = *tmpl;
+	list_insert_ordered(&spt->vma_list, &vma->elem, vma_less, NULL);
+	return vma;
+}
+
+/* VA를 포함하는 영역을 반환한다. 없으면 NULL. */
+struct vma *vma_find(struct supplemental_page_table *spt, const void *va)
+{
+	struct list_elem *e;
+	for (e = list_begin(&spt->vma_list); e != list_end(&spt->vma_list); e = list_next(e)) {
+		struct vma *vma = list_entry(e, struct vma, elem);
+		if (va < vma->start)
+			break;
+		if (va < vma->end)
+			return vma;
+	}
+	return NULL;
+}
+
+/* [START, END) 범위와 겹치는 영역이 있으면 true를 반환한다. */
+bool vma_overlaps(struct supplemental_page_table *spt, const void *start, const void *end)
+{
+	struct list_elem *e;
+	for (e = list_begin(&spt->vma_list); e != list_end(&spt->vma_list); e = list_next(e)) {
+		struct vma *vma = list_entry(e, struct vma, elem);
+		if (end <= vma->start)
+			break;
+		if (start < vma->end)
+			return true;
+	}
+	return false;
+}
+
+/* 영역 VMA 안의 주소 VA에 해당하는 uninit 페이지를 만들어 현재 스레드의 spt에 등록한다.
+ * 페이지마다 필요한 파일 위치는 영역의 시작으로부터의 거리로 계산한다. */
+bool vma_populate(struct vma *vma, void *va)
+{
+	va = pg_round_down(va);
+	ASSERT(vma->start <= va && va < vma->end);
+
+	size_t distance = va - vma->start;
+	size_t page_read_bytes = 0;
+	if (vma->read_bytes > distance)
+		page_read_bytes = vma->read_bytes - distance < PGSIZE ? vma->read_bytes - distance : PGSIZE;
+	off_t offset = vma->offset + distance;
+
+	void *aux = NULL;
+	if (vma->type & VM_LOAD_MARKER) {
+		struct vm_load_aux *load_aux = malloc(sizeof(*load_aux));
+		if (load_aux == NULL)
+			return false;
+		*load_aux = (struct vm_load_aux){
+			.offset = offset,
+			.page_read_bytes = page_read_bytes,
+			.fault_around = vma->fault_around,
+		};
+		aux = load_aux;
+	} else if (VM_TYPE(vma->type) == VM_FILE) {
+		struct mmap_aux *mmap_aux = malloc(sizeof(*mmap_aux));
+		if (mmap_aux == NULL)
+			return false;
+		*mmap_aux = (struct mmap_aux){
+			.file = vma->file,
+			.offset = offset,
+			.page_read_bytes = page_read_bytes,
+			.shared = vma->shared,
+			.fault_around = vma->fault_around,
+		};
+		aux = mmap_aux;
+	}
+
+	if (!vm_alloc_page_with_initializer(vma->type, va, vma->writable, vma->init, aux)) {
+		free(aux);
+		return false;
+	}
+	return true;
+}
+
+/* 영역 VMA를 없앤다. 영역 안에서 만들어진 페이지를 모두 정리하고 (수정된 파일 페이지는
+ * 다시 쓴다) mmap 영역이면 파일을 닫는다. */
+void vma_remove(struct supplemental_page_table *spt, struct vma *vma)
+{
+	spt_for_each(spt, vma->start, vma->end, vma_remove_page, spt);
+
+	list_remove(&vma->elem);
+	if (vma->owns_file)
+		file_close(vma->file);
+	free(vma);
+}
+
+/* 영역 VMA의 끝을 NEW_END로 옮긴다. 늘어나는 범위가 다른 영역과 겹치면 false.
+ * 줄어들면 잘려 나간 범위의 페이지를 정리하고, 남는 범위가 없으면 영역을 없앤다. */
+bool vma_resize(struct supplemental_page_table *spt, struct vma *vma, void *new_end)
+{
+	ASSERT(pg_ofs(new_end) == 0 && vma->start <= new_end);
+
+	if (new_end > vma->end) {
+		if (vma_overlaps(spt, vma->end, new_end))
+			return false;
+	} else if (new_end == vma->start) {
+		vma_remove(spt, vma);
+		return true;
+	} else
+		spt_for_each(spt, new_end, vma->end, vma_remove_page, spt);
+
+	vma->end = new_end;
+	return true;
+}
+
+/* fork 시 SRC의 영역들을 DST에 복사한다. mmap 영역의 파일은 다시 열고,
+ * 실행 파일 세그먼트는 자식이 복제한 실행 파일을 가리키게 한다.
+ * 현재 스레드가 DST의 소유자여야 한다. */
+bool vma_copy(struct supplemental_page_table *dst, struct supplemental_page_table *src)
+{
+	struct list_elem *e;
+	for (e = list_begin(&src->vma_list); e != list_end(&src->vma_list); e = list_next(e)) {
+		struct vma tmpl = *list_entry(e, struct vma, elem);
+
+		if (tmpl.owns_file) {
+			tmpl.file = file_reopen(tmpl.file);
+			if (tmpl.file == NULL)
+				return false;
+		} else if (tmpl.file != NULL)
+			tmpl.file = thread_current()->current_file;
+
+		if (vma_insert(dst, &tmpl) == NULL) {
+			if (tmpl.owns_file)
+				file_close(tmpl.file);
+			return false;
+		}
+	}
+	return true;
+}
+
+/* SPT의 영역을 모두 없앤다. 페이지는 이미 정리된 뒤에 호출한다. */
+void vma_kill(struct supplemental_page_table *spt)
+{
+	while (!list_empty(&spt->vma_list)) {
+		struct vma *vma = list_entry(list_pop_front(&spt->vma_list), struct vma, elem);
+		if (vma->owns_file)
+			file_close(vma->file);
+		free(vma);
+	}
+}
+
+/* 로드가 끝난 SPT의 힙을 마지막 영역(ELF 세그먼트) 바로 뒤에 빈 상태로 둔다. */
+void vma_heap_init(struct supplemental_page_table *spt)
+{
+	void *end = NULL;
+	if (!list_empty(&spt->vma_list))
+		end = list_entry(list_back(&spt->vma_list), struct vma, elem)->end;
+	spt->heap_start = spt->brk = end;
+}
+
+/* 힙의 끝(brk)을 INCREMENT 바이트 옮기고 이전 끝을 반환한다. 실패하면 (void *) -1.
+ * 힙도 하나의 anon 영역이므로 늘어난 페이지는 처음 접근할 때 0으로 채워지고,
+ * 줄어들어 영역 밖으로 나간 페이지는 프레임과 스왑 슬롯까지 정리된다.
+ * 다른 영역이나 스택 영역과 겹치게는 늘릴 수 없다. */
+void *vma_sbrk(struct supplemental_page_table *spt, intptr_t increment)
+{
+	void *old_brk = spt->brk;
+	void *new_brk = old_brk + increment;
+
+	if (spt->heap_start == NULL)
+		return (void *)-1;
+	if (increment < 0 ? new_brk < spt->heap_start || new_brk > old_brk : new_brk < old_brk)
+		return (void *)-1;
+	if (new_brk > (void *)(USER_STACK - (1 << 20)))
+		return (void *)-1;
+
+	void *old_end = pg_round_up(old_brk);
+	void *new_end = pg_round_up(new_brk);
+	if (new_end != old_end) {
+		struct vma *heap = old_end > spt->heap_start ? vma_find(spt, spt->heap_start) : NULL;
+		if (heap == NULL) {
+			struct vma tmpl = {
+				.start = spt->heap_start,
+				.end = new_end,
+				.type = VM_ANON,
+				.writable = true,
+				.fault_around = VM_FAULT_AROUND_DEFAULT,
+			};
+			if (vma_insert(spt, &tmpl) == NULL)
+				return (void *)-1;
+		} else if (!vma_resize(spt, heap, new_end))
+			return (void *)-1;
+	}
+
+	spt->brk = new_brk;
+	return old_brk;
+}
+
+static void vma_remove_page(struct page *page, void *spt)
+{
+	spt_remove_page(spt, page);
+}
+
+static bool vma_less(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED)
+{
+	return list_entry(a, struct vma, elem)->start < list_entry(b, struct vma, elem)->start;
+}